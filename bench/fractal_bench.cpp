@@ -0,0 +1,1040 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpu_renderer.hpp"
+#include "fixed.hpp"
+#include "max_iter_governor.hpp"
+#include "newton_renderer.hpp"
+#include "offscreen.hpp"
+#include "perturbation_renderer.hpp"
+#include "precision.hpp"
+#include "reference_orbit.hpp"
+
+#ifdef FRACTAL_BENCH_GPU
+#include "gpu_backend.hpp"
+#endif
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+
+double SecondsSince(Clock::time_point t) {
+  return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+
+// A point inside the Douady rabbit whose orbit never escapes, padded with
+// pseudo-random digits so that every limb of the multiplications is busy.
+std::string RabbitCoordinate(const char* prefix, int digits) {
+  std::string s = prefix;
+  unsigned int state = 12345;
+  for (int i = 0; i < digits; ++i) {
+    state = state*1103515245 + 12345;
+    s += static_cast<char>('0' + (state >> 16) % 10);
+  }
+  return s;
+}
+
+
+void BenchOrbit() {
+  std::printf("%-8s %8s %10s %12s\n", "backend", "bits", "iters", "iters/s");
+
+  for (const bool use_gmp : {false, true}) {
+    if (use_gmp && !kHaveGmp) {
+      continue;
+    }
+    for (const int bits : {256, 1024, 4096}) {
+      const int limbs = Fixed::LimbsForBits(bits);
+      const int digits = bits*3/10 + 10;
+      const BigComplex c{
+        Fixed::FromString(RabbitCoordinate("-0.1225611668766536", digits),
+                          limbs),
+        Fixed::FromString(RabbitCoordinate("0.7448617666197442", digits),
+                          limbs)};
+
+      ReferenceOrbit orbit;
+      orbit.use_gmp = use_gmp;
+      const int max_iter = 2000000/bits;
+      const auto t = Clock::now();
+      orbit.Compute(c, bits, max_iter);
+      const double seconds = SecondsSince(t);
+
+      std::printf("%-8s %8d %10d %12.0f\n", use_gmp ? "gmp" : "fixed", bits,
+                  orbit.length() - 1, (orbit.length() - 1)/seconds);
+    }
+  }
+}
+
+
+// Renders deep views with and without bilinear approximation and reports
+// the speedup together with the number of pixels whose count changed.
+void BenchBla() {
+  struct Location {
+    const char* name;
+    const char* x;
+    const char* y;
+    double height;
+    int max_iter;
+  };
+  const Location locations[] = {
+    {"needle-1e-12", "-1.99999911758766165543764649311537154663",
+     "-4.2402439547240753390707694210131039e-13", 1e-12, 20000},
+    {"needle-1e-30", "-1.99999911758766165543764649311537154663",
+     "-4.2402439547240753390707694210131039e-13", 1e-30, 20000},
+    {"needle-1e-100", "-1.99999911758766165543764649311537154663",
+     "-4.2402439547240753390707694210131039e-13", 1e-100, 20000},
+    {"seahorse-1e-25", "-0.743643887037158704752191506114774",
+     "0.131825904205311970493132056385139", 1e-25, 20000},
+  };
+
+  std::printf("%-16s %10s %10s %8s %8s %8s %5s\n", "location", "plain [s]",
+              "bla [s]", "speedup", "changed", "glitched", "refs");
+  for (const auto& location : locations) {
+    View view;
+    view.pixel_width = 320;
+    view.pixel_height = 240;
+    view.height = location.height;
+    view.max_iter = location.max_iter;
+    view.center = {0.0, 0.0};
+
+    const int limbs = Fixed::LimbsForBits(RequiredPrecision(view));
+    PerturbationRenderer renderer;
+    renderer.set_origin({Fixed::FromString(location.x, limbs),
+                         Fixed::FromString(location.y, limbs)});
+
+    IterationBuffer plain, bla;
+    renderer.set_use_bla(false);
+    renderer.Render(view, plain);  // Also computes the reference orbit.
+    auto t = Clock::now();
+    renderer.Render(view, plain);
+    const double plain_seconds = SecondsSince(t);
+
+    renderer.set_use_bla(true);
+    t = Clock::now();
+    renderer.Render(view, bla);
+    const double bla_seconds = SecondsSince(t);
+
+    int changed = 0;
+    for (size_t i = 0; i < plain.data.size(); ++i) {
+      changed += plain.data[i] != bla.data[i];
+    }
+    const auto& glitches = renderer.glitch_stats();
+    std::printf("%-16s %10.4f %10.4f %8.1f %8d %8ld %5d\n", location.name,
+                plain_seconds, bla_seconds, plain_seconds/bla_seconds,
+                changed, glitches.glitched_pixels, glitches.references);
+  }
+}
+
+
+// Renders views dominated by interior points with every CPU kernel, with
+// and without the cardioid/bulb test and cycle detection.
+void BenchInterior() {
+  struct Location {
+    const char* name;
+    double x;
+    double y;
+    double height;
+    int max_iter;
+  };
+  const Location locations[] = {
+    {"full-set", -0.75, 0.0, 2.5, 1000},
+    {"cardioid", -0.1, 0.0, 1.0, 5000},
+    {"bulb-edge", -0.75, 0.1, 0.05, 5000},
+    {"seahorse", -0.745, 0.11, 0.02, 5000},
+  };
+
+  std::printf("%-10s %-7s %10s %10s %8s %8s\n", "location", "isa",
+              "plain [s]", "checks [s]", "speedup", "changed");
+  for (const auto& location : locations) {
+    View view;
+    view.pixel_width = 640;
+    view.pixel_height = 480;
+    view.center = {location.x, location.y};
+    view.height = location.height;
+    view.max_iter = location.max_iter;
+
+    for (const Isa isa : {Isa::kScalar, Isa::kAvx2, Isa::kAvx512}) {
+      if (!IsaSupported(isa)) {
+        continue;
+      }
+      CpuRenderer renderer(0, isa);
+      IterationBuffer plain, checked;
+      renderer.set_interior_checks(false);
+      auto t = Clock::now();
+      renderer.Render(view, plain);
+      const double plain_seconds = SecondsSince(t);
+
+      renderer.set_interior_checks(true);
+      t = Clock::now();
+      renderer.Render(view, checked);
+      const double checked_seconds = SecondsSince(t);
+
+      int changed = 0;
+      for (size_t i = 0; i < plain.data.size(); ++i) {
+        changed += plain.data[i] != checked.data[i];
+      }
+      std::printf("%-10s %-7s %10.4f %10.4f %8.1f %8d\n", location.name,
+                  IsaName(isa), plain_seconds, checked_seconds,
+                  plain_seconds/checked_seconds, changed);
+    }
+  }
+}
+
+
+// Large renders with and without Mariani-Silver subdivision, in verify
+// mode so that every filled pixel is checked against brute force.
+void BenchSubdivision() {
+  struct Location {
+    const char* name;
+    double x;
+    double y;
+    double height;
+    int max_iter;
+  };
+  const Location locations[] = {
+    {"full-set", -0.75, 0.0, 2.5, 1000},
+    {"seahorse", -0.745, 0.11, 0.02, 5000},
+    {"elephant", 0.275, 0.006, 0.01, 5000},
+    {"spiral", -0.7436438870371587, 0.1318259042053119, 1e-6, 5000},
+  };
+
+  std::printf("%-10s %10s %10s %8s %9s %10s\n", "location", "brute [s]",
+              "subdiv [s]", "speedup", "skipped", "mismatched");
+  for (const auto& location : locations) {
+    View view;
+    view.pixel_width = 1920;
+    view.pixel_height = 1080;
+    view.center = {location.x, location.y};
+    view.height = location.height;
+    view.max_iter = location.max_iter;
+
+    CpuRenderer renderer;
+    IterationBuffer buffer;
+    auto t = Clock::now();
+    renderer.Render(view, buffer);
+    const double brute_seconds = SecondsSince(t);
+
+    renderer.set_subdivision(true);
+    t = Clock::now();
+    renderer.Render(view, buffer);
+    const double subdivided_seconds = SecondsSince(t);
+
+    renderer.set_verify(true);
+    renderer.Render(view, buffer);
+    const auto& stats = renderer.subdivision_stats();
+    const double pixels = static_cast<double>(buffer.data.size());
+    std::printf("%-10s %10.4f %10.4f %8.1f %8.1f%% %10ld\n", location.name,
+                brute_seconds, subdivided_seconds,
+                brute_seconds/subdivided_seconds,
+                100.0*stats.skipped_pixels/pixels, stats.mismatched_pixels);
+  }
+}
+
+
+// Frame time of the Newton renderer as max_iter grows, then per kernel and
+// polynomial degree. Pixels stop at convergence, so past a few dozen steps
+// the limit barely matters.
+void BenchNewton() {
+  View view;
+  view.pixel_width = 640;
+  view.pixel_height = 480;
+  view.center = {0.0, 0.0};
+  view.height = 3.0;
+
+  NewtonRenderer renderer;
+  IterationBuffer buffer;
+  std::printf("%8s %10s %12s %10s\n", "max_iter", "time [ms]", "steps/pixel",
+              "no root");
+  for (const int max_iter : {10, 30, 100, 300, 1000, 3000, 10000}) {
+    view.max_iter = max_iter;
+    const auto t = Clock::now();
+    renderer.Render(view, buffer);
+    const double seconds = SecondsSince(t);
+
+    long steps = 0;
+    int no_root = 0;
+    for (size_t i = 0; i < buffer.data.size(); ++i) {
+      steps += renderer.steps().data[i];
+      no_root += buffer.data[i] < 0;
+    }
+    std::printf("%8d %10.2f %12.2f %10d\n", max_iter, 1e3*seconds,
+                static_cast<double>(steps)/buffer.data.size(), no_root);
+  }
+
+  // Coefficients that are not all real, so the roots are irregular.
+  std::printf("\n%6s %-7s %10s %12s %8s\n", "degree", "isa", "time [ms]",
+              "Msteps/s", "changed");
+  view.max_iter = 200;
+  for (const int degree : {3, 5, 8, 12, 16}) {
+    std::vector<std::complex<double>> coefficients(degree + 1);
+    for (int k = 0; k <= degree; ++k) {
+      coefficients[k] = {std::cos(1.7*k), std::sin(0.9*k)};
+    }
+    const Polynomial polynomial(std::move(coefficients));
+    IterationBuffer reference;
+    for (const Isa isa : {Isa::kScalar, Isa::kAvx2, Isa::kAvx512}) {
+      if (!IsaSupported(isa)) {
+        continue;
+      }
+      NewtonRenderer newton(0, isa);
+      newton.set_polynomial(polynomial);
+      const auto t = Clock::now();
+      newton.Render(view, buffer);
+      const double seconds = SecondsSince(t);
+
+      long steps = 0;
+      int changed = 0;
+      for (size_t i = 0; i < buffer.data.size(); ++i) {
+        steps += newton.steps().data[i];
+      }
+      if (isa == Isa::kScalar) {
+        reference = buffer;
+      }
+      for (size_t i = 0; i < buffer.data.size(); ++i) {
+        changed += buffer.data[i] != reference.data[i];
+      }
+      std::printf("%6d %-7s %10.2f %12.1f %8d\n", degree, IsaName(isa),
+                  1e3*seconds, 1e-6*steps/seconds, changed);
+    }
+  }
+}
+
+
+// The max_iter governor driven by CPU frames, sampled on a 64x64 grid like
+// the viewer samples its GPU frames, from the default limit until it
+// settles.
+void BenchGovernor() {
+  struct Location {
+    const char* name;
+    double x;
+    double y;
+    double height;
+  };
+  const Location locations[] = {
+    {"full-set", -0.75, 0.0, 2.5},
+    {"seahorse", -0.745, 0.11, 0.02},
+    {"spiral", -0.7436438870371587, 0.1318259042053119, 1e-6},
+    {"minibrot", -1.7490863748149414, 0.0, 1e-9},
+  };
+  constexpr int kGrid = 64;
+
+  std::printf("%-10s %10s %s\n", "location", "budget", "max_iter (frame ms)");
+  for (const auto& location : locations) {
+    for (const double budget : {0.02, 0.1}) {
+      View view;
+      view.pixel_width = 960;
+      view.pixel_height = 540;
+      view.center = {location.x, location.y};
+      view.height = location.height;
+
+      CpuRenderer renderer;
+      MaxIterGovernor governor(budget);
+      IterationBuffer buffer;
+      std::printf("%-10s %8.0fms ", location.name, 1e3*budget);
+      for (int frame = 0; frame < 20; ++frame) {
+        const auto t = Clock::now();
+        renderer.Render(view, buffer);
+        const double seconds = SecondsSince(t);
+
+        IterationStats stats;
+        for (int j = 0; j < kGrid; ++j) {
+          for (int i = 0; i < kGrid; ++i) {
+            const int n = buffer.at(i*view.pixel_width/kGrid,
+                                    j*view.pixel_height/kGrid);
+            ++stats.samples;
+            if (n >= view.max_iter) {
+              ++stats.saturated;
+            }
+            else {
+              stats.escaped_sum += n;
+              stats.escaped_max = std::max<double>(stats.escaped_max, n);
+            }
+          }
+        }
+        std::printf(" %d (%.0f)", view.max_iter, 1e3*seconds);
+        const long pixels = static_cast<long>(buffer.data.size());
+        const int max_iter =
+            governor.Update(stats, view.max_iter, seconds, pixels, pixels);
+        if (max_iter == view.max_iter) {
+          break;
+        }
+        view.max_iter = max_iter;
+      }
+      std::printf("\n");
+    }
+  }
+}
+
+
+// One kernel over a whole view on one thread.
+double TimeMandelbrot(MandelbrotRowKernel kernel, const View& view,
+                      IterationBuffer& buffer) {
+  buffer.Resize(view.pixel_width, view.pixel_height);
+  const auto t = Clock::now();
+  for (int y = 0; y < view.pixel_height; ++y) {
+    kernel(view, y, 0, view.pixel_width, &buffer.at(0, y));
+  }
+  return SecondsSince(t);
+}
+
+
+double TimeNewton(NewtonRowKernel kernel, const Polynomial& polynomial,
+                  const View& view, IterationBuffer& roots,
+                  IterationBuffer& steps) {
+  roots.Resize(view.pixel_width, view.pixel_height);
+  steps.Resize(view.pixel_width, view.pixel_height);
+  const auto t = Clock::now();
+  for (int y = 0; y < view.pixel_height; ++y) {
+    kernel(polynomial, view, y, 0, view.pixel_width, &roots.at(0, y),
+           &steps.at(0, y));
+  }
+  return SecondsSince(t);
+}
+
+
+int CountMismatches(const IterationBuffer& a, const IterationBuffer& b) {
+  int mismatched = 0;
+  for (size_t i = 0; i < a.data.size(); ++i) {
+    mismatched += a.data[i] != b.data[i];
+  }
+  return mismatched;
+}
+
+
+// What double-double costs: the double and double-double kernels of every
+// ISA on views that double still resolves, without interior checks so that
+// both iterate every pixel. Then a view past the range of double rendered
+// both ways and by perturbation, which is taken as the truth. Everything
+// runs on one thread.
+void BenchDoubleDouble() {
+  View view;
+  view.pixel_width = 480;
+  view.pixel_height = 270;
+  view.center = {-0.745, 0.11};
+  view.height = 0.035/view.aspect_ratio();
+  view.max_iter = 2000;
+  View newton_view = view;
+  newton_view.center = {0.0, 0.0};
+  newton_view.height = 4.0/view.aspect_ratio();
+  newton_view.max_iter = 100;
+  const Polynomial polynomial = Polynomial::UnitRoots(3);
+
+  std::printf("%-10s %-7s %11s %9s %9s %8s\n", "view", "isa",
+              "double [ms]", "dd [ms]", "slowdown", "changed");
+  for (const Isa isa : {Isa::kScalar, Isa::kAvx2, Isa::kAvx512}) {
+    if (!IsaSupported(isa)) {
+      continue;
+    }
+    IterationBuffer plain, dd, plain_steps, dd_steps;
+    const double plain_seconds =
+        TimeMandelbrot(GetMandelbrotRowKernel(isa, false), view, plain);
+    const double dd_seconds =
+        TimeMandelbrot(GetMandelbrotDdRowKernel(isa, false), view, dd);
+    std::printf("%-10s %-7s %11.2f %9.2f %9.1f %8d\n", "seahorse",
+                IsaName(isa), 1e3*plain_seconds, 1e3*dd_seconds,
+                dd_seconds/plain_seconds, CountMismatches(plain, dd));
+
+    const double newton_seconds = TimeNewton(
+        GetNewtonRowKernel(isa), polynomial, newton_view, plain, plain_steps);
+    const double newton_dd_seconds = TimeNewton(
+        GetNewtonDdRowKernel(isa), polynomial, newton_view, dd, dd_steps);
+    std::printf("%-10s %-7s %11.2f %9.2f %9.1f %8d\n", "newton",
+                IsaName(isa), 1e3*newton_seconds, 1e3*newton_dd_seconds,
+                newton_dd_seconds/newton_seconds, CountMismatches(plain, dd));
+  }
+
+  // The seahorse spiral at a width double cannot resolve.
+  ImageJob job;
+  job.center_x = "-0.743643887037158704752191506114774";
+  job.center_y = "0.131825904205311970493132056385139";
+  job.width = 1e-20;
+  job.max_iter = 20000;
+  job.pixel_width = 480;
+  job.pixel_height = 270;
+  const View deep_view = JobView(job);
+
+  IterationBuffer reference;
+  PerturbationRenderer perturbation(1);
+  View offset_view = deep_view;
+  offset_view.center = {0.0, 0.0};
+  offset_view.center_lo = {0.0, 0.0};
+  const int limbs = Fixed::LimbsForBits(RequiredPrecision(offset_view));
+  perturbation.set_origin({Fixed::FromString(job.center_x, limbs),
+                           Fixed::FromString(job.center_y, limbs)});
+  // Timed once the reference orbit is there, as when panning.
+  perturbation.Render(offset_view, reference);
+  const auto t = Clock::now();
+  perturbation.Render(offset_view, reference);
+  const double perturbation_seconds = SecondsSince(t);
+  for (int& n : reference.data) {
+    n = n >= 0 ? n : -1 - n;
+  }
+
+  const Isa isa = DetectIsa();
+  std::printf("\nseahorse spiral at width %g, %dx%d, max_iter %d, %s\n",
+              job.width, job.pixel_width, job.pixel_height, job.max_iter,
+              IsaName(isa));
+  std::printf("%-14s %10s %11s\n", "mode", "time [ms]", "mismatched");
+  IterationBuffer buffer;
+  for (const bool dd : {false, true}) {
+    // The double kernel only sees the rounded center.
+    const double seconds = TimeMandelbrot(
+        dd ? GetMandelbrotDdRowKernel(isa) : GetMandelbrotRowKernel(isa),
+        deep_view, buffer);
+    std::printf("%-14s %10.2f %10.1f%%\n", dd ? "double-double" : "double",
+                1e3*seconds,
+                100.0*CountMismatches(buffer, reference)/buffer.data.size());
+  }
+  std::printf("%-14s %10.2f %11s\n", "perturbation",
+              1e3*perturbation_seconds, "-");
+}
+
+
+// Scalar mirrors of mandelbrot_float.frag and mandelbrot_df.frag, without
+// the interior and cycle checks, for measuring on the CPU what the shaders
+// get wrong. Like them they take the pixel offset in float from the
+// float-rounded view size, and this file is built without contraction so
+// that it rounds like `precise`.
+glm::vec2 FloatOffset(const View& view, int x, int y) {
+  const glm::vec2 size(view.width(), view.height);
+  return {((x + 0.5f)/view.pixel_width - 0.5f)*size.x,
+          ((y + 0.5f)/view.pixel_height - 0.5f)*size.y};
+}
+
+
+int FloatCount(const View& view, int x, int y) {
+  glm::vec2 center, unused;
+  SplitToFloats(view.center, &center, &unused);
+  const glm::vec2 offset = FloatOffset(view, x, y);
+  const float cx = center.x + offset.x;
+  const float cy = center.y + offset.y;
+  float zx = 0.0f;
+  float zy = 0.0f;
+  int n = 0;
+  while (n < view.max_iter && zx*zx + zy*zy < 4.0f) {
+    const float t = zx*zx - zy*zy + cx;
+    zy = 2.0f*zx*zy + cy;
+    zx = t;
+    ++n;
+  }
+  return n;
+}
+
+
+struct DoubleFloat {
+  float hi;
+  float lo;
+};
+
+
+DoubleFloat QuickTwoSum(float a, float b) {
+  const float s = a + b;
+  return {s, b - (s - a)};
+}
+
+
+DoubleFloat TwoSum(float a, float b) {
+  const float s = a + b;
+  const float bb = s - a;
+  return {s, (a - (s - bb)) + (b - bb)};
+}
+
+
+// Dekker's split into two 12-bit halves whose products are exact.
+DoubleFloat Split(float a) {
+  const float t = 4097.0f*a;
+  const float hi = t - (t - a);
+  return {hi, a - hi};
+}
+
+
+DoubleFloat TwoProd(float a, float b) {
+  const float p = a*b;
+  const DoubleFloat sa = Split(a);
+  const DoubleFloat sb = Split(b);
+  return {p, ((sa.hi*sb.hi - p) + sa.hi*sb.lo + sa.lo*sb.hi) + sa.lo*sb.lo};
+}
+
+
+DoubleFloat Add(DoubleFloat a, DoubleFloat b) {
+  const DoubleFloat s = TwoSum(a.hi, b.hi);
+  return QuickTwoSum(s.hi, (s.lo + a.lo) + b.lo);
+}
+
+
+DoubleFloat Add(DoubleFloat a, float b) {
+  const DoubleFloat s = TwoSum(a.hi, b);
+  return QuickTwoSum(s.hi, s.lo + a.lo);
+}
+
+
+DoubleFloat Mul(DoubleFloat a, DoubleFloat b) {
+  const DoubleFloat p = TwoProd(a.hi, b.hi);
+  return QuickTwoSum(p.hi, p.lo + (a.hi*b.lo + a.lo*b.hi));
+}
+
+
+DoubleFloat Sqr(DoubleFloat a) {
+  const DoubleFloat p = TwoProd(a.hi, a.hi);
+  return QuickTwoSum(p.hi, p.lo + 2.0f*(a.hi*a.lo));
+}
+
+
+int DoubleFloatCount(const View& view, int x, int y) {
+  glm::vec2 center, center_lo;
+  SplitToFloats(view.center, &center, &center_lo);
+  const glm::vec2 offset = FloatOffset(view, x, y);
+  const DoubleFloat cx = Add({center.x, center_lo.x}, offset.x);
+  const DoubleFloat cy = Add({center.y, center_lo.y}, offset.y);
+  DoubleFloat zx = {0.0f, 0.0f};
+  DoubleFloat zy = {0.0f, 0.0f};
+  int n = 0;
+  while (n < view.max_iter) {
+    const DoubleFloat x2 = Sqr(zx);
+    const DoubleFloat y2 = Sqr(zy);
+    if (x2.hi + y2.hi >= 4.0f) {
+      break;
+    }
+    const DoubleFloat xy = Mul(zx, zy);
+    zx = Add(Add(x2, {-y2.hi, -y2.lo}), cx);
+    zy = Add({2.0f*xy.hi, 2.0f*xy.lo}, cy);
+    ++n;
+  }
+  return n;
+}
+
+
+// Whether ChoosePrecision() keeps float and double-float to views they
+// draw like double: on the Mandelbrot scenes and the df suite's spiral,
+// at growing max_iter, the fraction of pixels whose count in float,
+// double-float and double-double differs from the double kernel's.
+// Double-double shows how many of those differences any rounding causes.
+void BenchPrecision() {
+  struct Location {
+    const char* name;
+    double x;
+    double y;
+    double width;
+  };
+  const Location locations[] = {
+    {"full-set", -0.75, 0.0, 3.5},
+    {"seahorse", -0.745, 0.11, 0.035},
+    {"elephant", 0.275, 0.006, 0.0178},
+    {"spiral-1e-5", -0.7436438870371587, 0.1318259042053119, 1e-5},
+    {"spiral-1e-8", -0.7436438870371587, 0.1318259042053119, 1e-8},
+  };
+  const Isa isa = DetectIsa();
+
+  std::printf("320x180, %s, changed pixels against double\n", IsaName(isa));
+  std::printf("%-12s %8s %-13s %8s %8s %8s\n", "view", "max_iter",
+              "picked", "float", "df", "dd");
+  IterationBuffer plain, dd;
+  for (const auto& location : locations) {
+    for (const int max_iter : {100, 1000, 10000}) {
+      View view;
+      view.pixel_width = 320;
+      view.pixel_height = 180;
+      view.center = {location.x, location.y};
+      view.height = location.width/view.aspect_ratio();
+      view.max_iter = max_iter;
+      TimeMandelbrot(GetMandelbrotRowKernel(isa, false), view, plain);
+      TimeMandelbrot(GetMandelbrotDdRowKernel(isa, false), view, dd);
+      int float_changed = 0;
+      int df_changed = 0;
+      for (int y = 0; y < view.pixel_height; ++y) {
+        for (int x = 0; x < view.pixel_width; ++x) {
+          const int n = plain.at(x, y);
+          float_changed += FloatCount(view, x, y) != n;
+          df_changed += DoubleFloatCount(view, x, y) != n;
+        }
+      }
+      const double pixels = plain.data.size();
+      std::printf("%-12s %8d %-13s %7.1f%% %7.1f%% %7.1f%%\n",
+                  location.name, max_iter,
+                  PrecisionName(ChoosePrecision(view, true)),
+                  100.0*float_changed/pixels, 100.0*df_changed/pixels,
+                  100.0*CountMismatches(plain, dd)/pixels);
+      std::fflush(stdout);
+    }
+  }
+}
+
+
+ImageJob Scene(FractalType type, const char* x, const char* y, double width,
+               int max_iter) {
+  ImageJob job;
+  job.type = type;
+  job.center_x = x;
+  job.center_y = y;
+  job.width = width;
+  job.max_iter = max_iter;
+  job.pixel_width = 1280;
+  job.pixel_height = 720;
+  return job;
+}
+
+
+// A renderer under test. Render() returns the time one image took and the
+// sum of its iteration counts.
+struct Backend {
+  std::string name;
+  std::vector<FractalType> types;
+  std::function<double(const ImageJob&, double* iterations)> render;
+};
+
+
+std::vector<Backend> SceneBackends() {
+  std::vector<Backend> backends;
+  for (const Isa isa : {Isa::kScalar, Isa::kAvx2, Isa::kAvx512}) {
+    if (!IsaSupported(isa)) {
+      continue;
+    }
+    auto cpu = std::make_shared<CpuRenderer>(0, isa);
+    auto buffer = std::make_shared<IterationBuffer>();
+    backends.push_back({
+      std::string("cpu-") + IsaName(isa), {FractalType::kMandelbrot},
+      [cpu, buffer](const ImageJob& job, double* iterations) {
+        const auto t = Clock::now();
+        cpu->Render(JobView(job), *buffer);
+        const double seconds = SecondsSince(t);
+        *iterations = 0.0;
+        for (const int n : buffer->data) {
+          *iterations += n;
+        }
+        return seconds;
+      }});
+  }
+
+  auto deep = std::make_shared<PerturbationRenderer>();
+  auto deep_buffer = std::make_shared<IterationBuffer>();
+  backends.push_back({
+    "perturbation", {FractalType::kDeep},
+    [deep, deep_buffer](const ImageJob& job, double* iterations) {
+      View view = JobView(job);
+      view.center = {0.0, 0.0};
+      view.center_lo = {0.0, 0.0};
+      const int limbs = Fixed::LimbsForBits(RequiredPrecision(view));
+      deep->set_origin({Fixed::FromString(job.center_x, limbs),
+                        Fixed::FromString(job.center_y, limbs)});
+      const auto t = Clock::now();
+      deep->Render(view, *deep_buffer);
+      const double seconds = SecondsSince(t);
+      *iterations = 0.0;
+      for (const int n : deep_buffer->data) {
+        *iterations += n >= 0 ? n : -1 - n;
+      }
+      return seconds;
+    }});
+
+  for (const Isa isa : {Isa::kScalar, Isa::kAvx2, Isa::kAvx512}) {
+    if (!IsaSupported(isa)) {
+      continue;
+    }
+    auto newton = std::make_shared<NewtonRenderer>(0, isa);
+    auto buffer = std::make_shared<IterationBuffer>();
+    backends.push_back({
+      std::string("newton-") + IsaName(isa), {FractalType::kNewton},
+      [newton, buffer](const ImageJob& job, double* iterations) {
+        newton->set_polynomial(job.polynomial);
+        const auto t = Clock::now();
+        newton->Render(JobView(job), *buffer);
+        const double seconds = SecondsSince(t);
+        *iterations = 0.0;
+        for (const int n : newton->steps().data) {
+          *iterations += n;
+        }
+        return seconds;
+      }});
+  }
+
+#ifdef FRACTAL_BENCH_GPU
+  auto gpu = std::make_shared<GpuBackend>();
+  if (gpu->ok()) {
+    backends.push_back({
+      "gpu",
+      {FractalType::kMandelbrot, FractalType::kDeep, FractalType::kNewton},
+      [gpu](const ImageJob& job, double* iterations) {
+        return gpu->Render(job, iterations);
+      }});
+  }
+#endif
+  return backends;
+}
+
+
+// A fixed catalog of views rendered by every backend that can draw them,
+// for tracking performance across changes. Times are the best of
+// kRepeats renders after a warm-up one, which also computes the reference
+// orbits. Iterations are the counts of the image, whether the backend ran
+// them or skipped them with interior checks or BLA.
+void BenchScenes(bool json) {
+  constexpr int kRepeats = 3;
+  const std::pair<const char*, ImageJob> scenes[] = {
+    {"full-set", Scene(FractalType::kMandelbrot, "-0.75", "0", 3.5, 1000)},
+    {"seahorse", Scene(FractalType::kMandelbrot, "-0.745", "0.11", 0.035,
+                       2000)},
+    {"elephant", Scene(FractalType::kMandelbrot, "0.275", "0.006", 0.0178,
+                       2000)},
+    // A period-72 minibrot on the real axis, far beyond double precision.
+    {"deep-minibrot",
+     Scene(FractalType::kDeep, "-1.74908637481494136239284329377270444088",
+           "0", 1e-15, 20000)},
+    {"newton", Scene(FractalType::kNewton, "0", "0", 4.0, 100)},
+  };
+
+  const std::vector<Backend> backends = SceneBackends();
+  if (json) {
+    std::printf("{\"isa\": \"%s\", \"threads\": %u, \"results\": [",
+                IsaName(DetectIsa()), std::thread::hardware_concurrency());
+  }
+  else {
+    std::printf("%-14s %-14s %10s %12s %12s\n", "scene", "backend",
+                "time [ms]", "Mpixels/s", "Giters/s");
+  }
+  bool first = true;
+  for (const auto& [scene, job] : scenes) {
+    for (const Backend& backend : backends) {
+      if (std::find(backend.types.begin(), backend.types.end(), job.type) ==
+          backend.types.end()) {
+        continue;
+      }
+      double iterations = 0.0;
+      backend.render(job, &iterations);
+      double seconds = backend.render(job, &iterations);
+      for (int i = 1; i < kRepeats; ++i) {
+        seconds = std::min(seconds, backend.render(job, &iterations));
+      }
+
+      const double pixels =
+          static_cast<double>(job.pixel_width)*job.pixel_height;
+      if (json) {
+        std::printf("%s\n  {\"scene\": \"%s\", \"backend\": \"%s\", "
+                    "\"width\": %d, \"height\": %d, \"max_iter\": %d, "
+                    "\"seconds\": %.6g, \"pixels_per_second\": %.6g, "
+                    "\"iterations_per_second\": %.6g}",
+                    first ? "" : ",", scene, backend.name.c_str(),
+                    job.pixel_width, job.pixel_height, job.max_iter, seconds,
+                    pixels/seconds, iterations/seconds);
+      }
+      else {
+        std::printf("%-14s %-14s %10.2f %12.1f %12.2f\n", scene,
+                    backend.name.c_str(), 1e3*seconds, 1e-6*pixels/seconds,
+                    1e-9*iterations/seconds);
+      }
+      std::fflush(stdout);
+      first = false;
+    }
+  }
+  if (json) {
+    std::printf("\n]}\n");
+  }
+}
+
+
+#ifdef FRACTAL_BENCH_GPU
+// Whole iteration counts of a Mandelbrot image from the GPU backend, with
+// the smoothing undone as in color.frag.
+std::vector<int> GpuCounts(const std::vector<float>& pixels) {
+  std::vector<int> counts(pixels.size()/2);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    const float n = pixels[2*i];
+    const float r = pixels[2*i+1];
+    counts[i] = static_cast<int>(
+        r >= 2.0f ? std::round(n - 1 + std::log2(std::log(r))) : n);
+  }
+  return counts;
+}
+
+
+// The float, double-float and double Mandelbrot shaders on the same views,
+// from a shallow one to about the deepest the viewer draws in double-float.
+// Mismatched pixels are those whose count differs from the double
+// shader's. Times are the best of kRepeats renders. Without
+// GL_ARB_gpu_shader5 there is no double-float row.
+void BenchDoubleFloat() {
+  constexpr int kRepeats = 3;
+  struct Location {
+    const char* name;
+    const char* x;
+    const char* y;
+    double width;
+    int max_iter;
+  };
+  const Location locations[] = {
+    {"seahorse", "-0.745", "0.11", 0.035, 2000},
+    {"spiral-1e-5", "-0.7436438870371587", "0.1318259042053119", 1e-5,
+     5000},
+    {"spiral-1e-8", "-0.7436438870371587", "0.1318259042053119", 1e-8,
+     5000},
+  };
+
+  GpuBackend gpu;
+  if (!gpu.ok()) {
+    std::printf("no GL context\n");
+    return;
+  }
+  std::vector<Precision> precisions = {Precision::kFloat};
+  if (gpu.double_float()) {
+    precisions.push_back(Precision::kDoubleFloat);
+  }
+  precisions.push_back(Precision::kDouble);
+  const size_t n = precisions.size();
+  std::printf("%s, * marks what the viewer picks with D\n",
+              gpu.renderer_name().c_str());
+  std::printf("%-12s %-14s %10s %10s %8s %11s\n", "view", "mode",
+              "time [ms]", "Giters/s", "speedup", "mismatched");
+  for (const auto& location : locations) {
+    ImageJob job = Scene(FractalType::kMandelbrot, location.x, location.y,
+                         location.width, location.max_iter);
+    job.pixel_width = 640;
+    job.pixel_height = 360;
+    const Precision picked =
+        ChoosePrecision(JobView(job), gpu.double_float());
+
+    std::vector<double> seconds(n);
+    std::vector<double> iterations(n);
+    std::vector<std::vector<int>> counts(n);
+    for (size_t i = 0; i < n; ++i) {
+      gpu.Render(job, precisions[i], &iterations[i]);
+      seconds[i] = gpu.Render(job, precisions[i], &iterations[i]);
+      for (int k = 1; k < kRepeats; ++k) {
+        seconds[i] = std::min(seconds[i],
+                              gpu.Render(job, precisions[i], &iterations[i]));
+      }
+      counts[i] = GpuCounts(gpu.pixels());
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      int mismatched = 0;
+      for (size_t k = 0; k < counts[i].size(); ++k) {
+        mismatched += counts[i][k] != counts[n-1][k];
+      }
+      const std::string mode = std::string(PrecisionName(precisions[i])) +
+                               (precisions[i] == picked ? "*" : "");
+      std::printf("%-12s %-14s %10.2f %10.2f %8.1f %10.1f%%\n",
+                  location.name, mode.c_str(), 1e3*seconds[i],
+                  1e-9*iterations[i]/seconds[i], seconds[n-1]/seconds[i],
+                  100.0*mismatched/counts[i].size());
+    }
+  }
+}
+#endif
+
+
+#ifdef FRACTAL_BENCH_GPU
+// What keeping the camera in View saved: the viewer's per-frame camera
+// update with the old glGetUniformdv readbacks against the View, each
+// followed by a small frame on the same context.
+void BenchCamera() {
+  constexpr int kFrames = 2000;
+  GpuBackend gpu;
+  if (!gpu.ok()) {
+    std::printf("no GL context\n");
+    return;
+  }
+  std::printf("%s, %d frames\n", gpu.renderer_name().c_str(), kFrames);
+  std::printf("%-10s %12s %12s\n", "camera", "update [us]", "frame [us]");
+  for (const bool readback : {true, false}) {
+    double update_seconds = 0.0;
+    double frame_seconds = 0.0;
+    gpu.TimeCameraFrames(readback, kFrames, &update_seconds, &frame_seconds);
+    std::printf("%-10s %12.2f %12.2f\n", readback ? "readback" : "view",
+                1e6*update_seconds, 1e6*frame_seconds);
+  }
+}
+#endif
+
+
+void PrintUsage() {
+  std::printf("usage: fractal_bench <suite> [--json]\n"
+              "suites:\n"
+              "  orbit     reference orbit iterations per second\n"
+              "  bla       perturbation with and without BLA skipping\n"
+              "  interior  CPU kernels with and without interior checks\n"
+              "  subdiv    CPU renders with Mariani-Silver subdivision\n"
+              "  newton    Newton frame time against max_iter and degree\n"
+              "  governor  max_iter chosen for a frame budget\n"
+              "  camera    viewer camera update with and without uniform\n"
+              "            readbacks (builds with the GPU backend only)\n"
+              "  dd        double-double kernels against double and\n"
+              "            perturbation\n"
+              "  precision float and double-float against double on the\n"
+              "            views ChoosePrecision() gives them\n"
+              "  df        float, double-float and double GPU shaders\n"
+              "            (builds with the GPU backend only)\n"
+              "  scenes    pixels/s and iterations/s of every backend on a\n"
+              "            fixed set of views; --json for machine-readable\n"
+              "            output\n");
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    PrintUsage();
+    return 1;
+  }
+
+  if (std::strcmp(argv[1], "orbit") == 0) {
+    BenchOrbit();
+  }
+  else if (std::strcmp(argv[1], "bla") == 0) {
+    BenchBla();
+  }
+  else if (std::strcmp(argv[1], "interior") == 0) {
+    BenchInterior();
+  }
+  else if (std::strcmp(argv[1], "subdiv") == 0) {
+    BenchSubdivision();
+  }
+  else if (std::strcmp(argv[1], "newton") == 0) {
+    BenchNewton();
+  }
+  else if (std::strcmp(argv[1], "governor") == 0) {
+    BenchGovernor();
+  }
+  else if (std::strcmp(argv[1], "dd") == 0) {
+    BenchDoubleDouble();
+  }
+  else if (std::strcmp(argv[1], "precision") == 0) {
+    BenchPrecision();
+  }
+  else if (std::strcmp(argv[1], "camera") == 0) {
+#ifdef FRACTAL_BENCH_GPU
+    BenchCamera();
+#else
+    std::printf("fractal_bench was built without the GPU backend\n");
+    return 1;
+#endif
+  }
+  else if (std::strcmp(argv[1], "df") == 0) {
+#ifdef FRACTAL_BENCH_GPU
+    BenchDoubleFloat();
+#else
+    std::printf("fractal_bench was built without the GPU backend\n");
+    return 1;
+#endif
+  }
+  else if (std::strcmp(argv[1], "scenes") == 0) {
+    BenchScenes(argc > 2 && std::strcmp(argv[2], "--json") == 0);
+  }
+  else {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
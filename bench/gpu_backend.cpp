@@ -0,0 +1,314 @@
+#include "gpu_backend.hpp"
+
+#include <chrono>
+#include <cmath>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "precision.hpp"
+#include "reference_orbit.hpp"
+
+
+GpuBackend::GpuBackend() {
+  if (!glfwInit()) {
+    return;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  window_ = glfwCreateWindow(64, 64, "fractal_bench", nullptr, nullptr);
+  if (window_ == nullptr) {
+    glfwTerminate();
+    return;
+  }
+  glfwMakeContextCurrent(window_);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    glfwDestroyWindow(window_);
+    glfwTerminate();
+    window_ = nullptr;
+    return;
+  }
+
+  mandelbrot_ = std::make_unique<Shader>("shaders/default.vert",
+                                         "shaders/mandelbrot.frag");
+  mandelbrot_float_ = std::make_unique<Shader>(
+      "shaders/default.vert", "shaders/mandelbrot_float.frag");
+  if (HasGlExtension("GL_ARB_gpu_shader5")) {
+    mandelbrot_df_ = std::make_unique<Shader>("shaders/default.vert",
+                                              "shaders/mandelbrot_df.frag");
+  }
+  mandelbrot_dd_ = std::make_unique<Shader>("shaders/default.vert",
+                                            "shaders/mandelbrot_dd.frag");
+  newton_ = std::make_unique<Shader>("shaders/default.vert",
+                                     "shaders/newton.frag");
+  newton_float_ = std::make_unique<Shader>("shaders/default.vert",
+                                           "shaders/newton_float.frag");
+  newton_dd_ = std::make_unique<Shader>("shaders/default.vert",
+                                        "shaders/newton_dd.frag");
+  perturbation_ = std::make_unique<Shader>("shaders/default.vert",
+                                           "shaders/perturbation.frag");
+  newton_->BindUniformBlock("Polynomial", PolynomialBuffer::kBinding);
+  newton_float_->BindUniformBlock("Polynomial", PolynomialBuffer::kBinding);
+  newton_dd_->BindUniformBlock("Polynomial", PolynomialBuffer::kBinding);
+  perturbation_->Use();
+  perturbation_->SetUniform("orbit", 0);
+
+  const float vertices[] = {
+     1.0f,  1.0f, 0.0f,
+     1.0f, -1.0f, 0.0f,
+    -1.0f, -1.0f, 0.0f,
+    -1.0f,  1.0f, 0.0f
+  };
+  const unsigned int indices[] = {0, 1, 3, 1, 2, 3};
+  unsigned int buffers[2];
+  glGenBuffers(2, buffers);
+  glGenVertexArrays(1, &vao_);
+  glBindVertexArray(vao_);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
+               GL_STATIC_DRAW);
+
+  glGenFramebuffers(1, &fbo_);
+  glGenTextures(1, &texture_);
+
+  glGenBuffers(1, &orbit_buffer_);
+  glGenTextures(1, &orbit_texture_);
+  glBindBuffer(GL_TEXTURE_BUFFER, orbit_buffer_);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_BUFFER, orbit_texture_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, orbit_buffer_);
+
+  polynomial_buffer_ = std::make_unique<PolynomialBuffer>();
+}
+
+
+GpuBackend::~GpuBackend() {
+  if (window_ != nullptr) {
+    polynomial_buffer_.reset();
+    glfwDestroyWindow(window_);
+    glfwTerminate();
+  }
+}
+
+
+std::string GpuBackend::renderer_name() const {
+  return window_ != nullptr
+      ? reinterpret_cast<const char*>(glGetString(GL_RENDERER))
+      : "none";
+}
+
+
+// Like the viewer by default, takes the cheapest shader ChoosePrecision()
+// allows without double-float.
+double GpuBackend::Render(const ImageJob& job, double* iterations) {
+  return Render(job, ChoosePrecision(JobView(job)), iterations);
+}
+
+
+double GpuBackend::Render(const ImageJob& job, Precision precision,
+                          double* iterations) {
+  View view = JobView(job);
+
+  Shader* shader = mandelbrot_dd_.get();
+  if (precision == Precision::kFloat) {
+    shader = mandelbrot_float_.get();
+  }
+  else if (precision == Precision::kDoubleFloat) {
+    shader = mandelbrot_df_.get();
+  }
+  else if (precision == Precision::kDouble) {
+    shader = mandelbrot_.get();
+  }
+  if (job.type == FractalType::kNewton) {
+    shader = precision == Precision::kFloat ? newton_float_.get()
+           : precision <= Precision::kDouble ? newton_.get()
+           : newton_dd_.get();
+    polynomial_buffer_->Upload(job.polynomial);
+  }
+  else if (job.type == FractalType::kDeep ||
+           precision == Precision::kPerturbation) {
+    shader = perturbation_.get();
+    UploadOrbit(job, &view);
+  }
+
+  Resize(view.pixel_width, view.pixel_height);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glViewport(0, 0, view.pixel_width, view.pixel_height);
+  shader->Use();
+  shader->SetUniform("window_width", view.pixel_width);
+  shader->SetUniform("window_height", view.pixel_height);
+  shader->SetUniform("fractal_center", view.center);
+  shader->SetUniform("fractal_center_lo", view.center_lo);
+  shader->SetUniform("fractal_width", view.width());
+  shader->SetUniform("fractal_height", view.height);
+  shader->SetUniform("max_iter", view.max_iter);
+  glm::vec2 center, center_lo;
+  SplitToFloats(view.center, &center, &center_lo);
+  shader->SetUniform("float_center", center);
+  shader->SetUniform("float_center_lo", center_lo);
+  shader->SetUniform("float_size", glm::vec2(view.width(), view.height));
+  glBindVertexArray(vao_);
+
+  // Wall clock rather than a GL_TIME_ELAPSED query: software renderers
+  // such as llvmpipe rasterize outside the query and report almost zero.
+  glFinish();
+  const auto start = std::chrono::steady_clock::now();
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  glFinish();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  // Smooth counts for the Mandelbrot shaders, (root, steps) for Newton.
+  pixels_.resize(2*static_cast<size_t>(width_)*height_);
+  glReadPixels(0, 0, width_, height_, GL_RG, GL_FLOAT, pixels_.data());
+  const int channel = job.type == FractalType::kNewton ? 1 : 0;
+  double sum = 0.0;
+  for (size_t i = channel; i < pixels_.size(); i += 2) {
+    sum += pixels_[i];
+  }
+  *iterations = sum;
+  return elapsed.count();
+}
+
+
+void GpuBackend::TimeCameraFrames(bool readback, int frames,
+                                  double* update_seconds,
+                                  double* frame_seconds) {
+  using Clock = std::chrono::steady_clock;
+  constexpr double kDt = 1.0/60.0;
+  constexpr double kZoomMomentum = 1.0;
+  const glm::dvec2 scroll_momentum{1e-3, 0.0};
+  const glm::dvec2 cursor{200.0, 100.0};
+
+  View view;
+  view.pixel_width = 320;
+  view.pixel_height = 180;
+  view.center = {-0.745, 0.11};
+  view.height = 0.02;
+  view.max_iter = 200;
+  Resize(view.pixel_width, view.pixel_height);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glViewport(0, 0, view.pixel_width, view.pixel_height);
+  glBindVertexArray(vao_);
+
+  Shader& shader = *mandelbrot_;
+  shader.Use();
+  shader.SetUniform("window_width", view.pixel_width);
+  shader.SetUniform("window_height", view.pixel_height);
+  shader.SetUniform("fractal_center", view.center);
+  shader.SetUniform("fractal_width", view.width());
+  shader.SetUniform("fractal_height", view.height);
+  shader.SetUniform("max_iter", view.max_iter);
+
+  // The accessors Fractal had before View.
+  auto read = [&](const char* name) {
+    double v[2] = {};
+    glGetUniformdv(shader.id, glGetUniformLocation(shader.id, name), v);
+    return glm::dvec2(v[0], v[1]);
+  };
+  auto aspect_ratio = [&] {
+    int w, h;
+    glfwGetWindowSize(window_, &w, &h);
+    return static_cast<double>(view.pixel_width)/view.pixel_height;
+  };
+  auto pixel_to_world = [&](glm::dvec2 p) {
+    const glm::dvec2 center = read("fractal_center");
+    const double px = p.x/view.pixel_width;
+    const double py = p.y/view.pixel_height;
+    return glm::dvec2(center.x + (px-0.5)*read("fractal_width").x,
+                      center.y + (0.5-py)*read("fractal_height").x);
+  };
+
+  const auto center = shader.GetUniform<glm::dvec2>("fractal_center");
+  const auto width = shader.GetUniform<double>("fractal_width");
+  const auto height = shader.GetUniform<double>("fractal_height");
+  const auto max_iter = shader.GetUniform<int>("max_iter");
+
+  double update = 0.0;
+  glFinish();
+  const auto start = Clock::now();
+  for (int frame = 0; frame < frames; ++frame) {
+    const auto t = Clock::now();
+    shader.Use();
+    if (readback) {
+      shader.SetUniform("fractal_height", read("fractal_height").x*
+                                          std::exp(-kZoomMomentum*kDt));
+      shader.SetUniform("fractal_width",
+                        read("fractal_height").x*aspect_ratio());
+      const glm::dvec2 dir = pixel_to_world(cursor) - read("fractal_center");
+      shader.SetUniform("fractal_center",
+                        read("fractal_center") + kZoomMomentum*kDt*dir);
+      shader.SetUniform("fractal_center",
+                        read("fractal_center") + kDt*scroll_momentum);
+      // The automatic limit was derived from the width. It stays fixed
+      // here so that both loops draw the same frames.
+      read("fractal_width");
+      shader.SetUniform("max_iter", view.max_iter);
+    }
+    else {
+      view.height *= std::exp(-kZoomMomentum*kDt);
+      view.Move(kZoomMomentum*kDt*view.PixelToOffset(cursor));
+      view.Move(kDt*scroll_momentum);
+      shader.SetUniform(center, view.center);
+      shader.SetUniform(width, view.width());
+      shader.SetUniform(height, view.height);
+      shader.SetUniform(max_iter, view.max_iter);
+    }
+    update += std::chrono::duration<double>(Clock::now() - t).count();
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glFinish();
+  }
+  const double total =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  *update_seconds = update/frames;
+  *frame_seconds = total/frames;
+}
+
+
+void GpuBackend::Resize(int width, int height) {
+  if (width == width_ && height == height_) {
+    return;
+  }
+  width_ = width;
+  height_ = height;
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT,
+               nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         texture_, 0);
+}
+
+
+// The reference orbit is computed at the job's center, so the view is
+// centered on it.
+void GpuBackend::UploadOrbit(const ImageJob& job, View* view) {
+  view->center = {0.0, 0.0};
+  view->center_lo = {0.0, 0.0};
+  const int limbs = Fixed::LimbsForBits(RequiredPrecision(*view));
+  const BigComplex c{Fixed::FromString(job.center_x, limbs),
+                     Fixed::FromString(job.center_y, limbs)};
+  ReferenceOrbit orbit;
+  orbit.Update(c, *view);
+
+  std::vector<double> data(2*orbit.length());
+  for (int n = 0; n < orbit.length(); ++n) {
+    data[2*n] = orbit.re[n];
+    data[2*n+1] = orbit.im[n];
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, orbit_buffer_);
+  glBufferData(GL_TEXTURE_BUFFER, data.size()*sizeof(double), data.data(),
+               GL_STATIC_DRAW);
+  perturbation_->Use();
+  perturbation_->SetUniform("orbit_length", orbit.length());
+}
+
@@ -0,0 +1,81 @@
+#ifndef GPU_BACKEND_HPP_
+#define GPU_BACKEND_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "offscreen.hpp"
+#include "polynomial_buffer.hpp"
+#include "precision.hpp"
+#include "shader.hpp"
+
+struct GLFWwindow;
+
+
+// Renders images with the viewer's fragment shaders in a hidden window, so
+// that fractal_bench can compare shader changes like CPU ones. Pixels are
+// computed once per Render() into an RG32F texture, as in the viewer, but
+// never coloured.
+class GpuBackend {
+ public:
+  GpuBackend();
+  ~GpuBackend();
+  GpuBackend(const GpuBackend&) = delete;
+  GpuBackend& operator=(const GpuBackend&) = delete;
+
+  // False if no GL context could be created.
+  bool ok() const { return window_ != nullptr; }
+  // Whether the double-float shader could be loaded, which takes
+  // GL_ARB_gpu_shader5.
+  bool double_float() const { return mandelbrot_df_ != nullptr; }
+  std::string renderer_name() const;
+
+  // Wall-clock time of the iteration pass in seconds, between glFinish
+  // calls. *iterations is the sum of the counts written, smooth ones
+  // included.
+  double Render(const ImageJob&, double* iterations);
+  // The same with the shader of `precision` rather than the one the viewer
+  // would pick. Deep jobs always run the perturbation shader, as do
+  // Mandelbrot ones at kPerturbation, and kDoubleFloat needs
+  // double_float().
+  double Render(const ImageJob&, Precision, double* iterations);
+
+  // CPU time per frame of a zooming, scrolling camera update followed by a
+  // small Mandelbrot frame, averaged over `frames`. With `readback` the
+  // camera lives in the shader's uniforms and is read back through
+  // glGetUniformLocation and glGetUniformdv as often as Fractal::Render()
+  // did before View; otherwise a View is pushed through cached handles.
+  // *update_seconds is the uniform traffic alone.
+  void TimeCameraFrames(bool readback, int frames, double* update_seconds,
+                        double* frame_seconds);
+
+  // What the last Render() wrote: two floats per pixel, bottom row first.
+  const std::vector<float>& pixels() const { return pixels_; }
+
+ private:
+  void Resize(int width, int height);
+  void UploadOrbit(const ImageJob&, View*);
+
+  GLFWwindow* window_ = nullptr;
+  std::unique_ptr<Shader> mandelbrot_;
+  std::unique_ptr<Shader> mandelbrot_float_;
+  std::unique_ptr<Shader> mandelbrot_df_;
+  std::unique_ptr<Shader> mandelbrot_dd_;
+  std::unique_ptr<Shader> newton_;
+  std::unique_ptr<Shader> newton_float_;
+  std::unique_ptr<Shader> newton_dd_;
+  std::unique_ptr<Shader> perturbation_;
+  unsigned int vao_ = 0;
+  unsigned int fbo_ = 0;
+  unsigned int texture_ = 0;
+  unsigned int orbit_buffer_ = 0;
+  unsigned int orbit_texture_ = 0;
+  std::unique_ptr<PolynomialBuffer> polynomial_buffer_;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<float> pixels_;
+};
+
+
+#endif
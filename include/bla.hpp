@@ -0,0 +1,62 @@
+#ifndef BLA_HPP_
+#define BLA_HPP_
+
+#include <vector>
+
+#include "reference_orbit.hpp"
+
+
+// One bilinear approximation d_{n+length} = A d_n + B dc of `length`
+// consecutive perturbation steps, valid while |d_n|^2 < r2.
+struct BlaStep {
+  double ax, ay;
+  double bx, by;
+  double r2;
+  int length;
+};
+
+
+// Bilinear approximations of a reference orbit, arranged as a binary tree:
+// level k holds steps of length 2^k starting at iterations 1 + i*2^k. A
+// single step n -> n+1 is approximated by A = 2 Z_n, B = 1, which holds as
+// long as the dropped d^2 term is below `epsilon` relative to A d. Two
+// adjacent approximations x then y merge into A = A_y A_x,
+// B = A_y B_x + B_y with radius min(R_x, (R_y - |B_x| max|dc|)/|A_x|).
+class BlaTable {
+ public:
+  void Build(const ReferenceOrbit&, double max_dc, double epsilon = 0x1p-53);
+
+  // The longest approximation that starts at iteration n, is valid for
+  // offsets with |d|^2 = d2 and ends no later than iteration `limit`.
+  // Called once per iteration by the kernels, hence inline. A merged
+  // radius never exceeds the radius of its first half, so the search climbs
+  // from single steps and stops at the first level that fails.
+  const BlaStep* Lookup(int n, double d2, int limit) const {
+    if (n < 1) {
+      return nullptr;
+    }
+    const int m = n - 1;
+    const int aligned = m == 0 ? levels() - 1 : __builtin_ctz(m);
+    const BlaStep* best = nullptr;
+    for (int k = 0; k <= aligned && k < levels(); ++k) {
+      const size_t i = static_cast<size_t>(m) >> k;
+      if (i >= levels_[k].size()) {
+        break;
+      }
+      const BlaStep& step = levels_[k][i];
+      if (!(d2 < step.r2) || n + step.length > limit) {
+        break;
+      }
+      best = &step;
+    }
+    return best;
+  }
+
+  int levels() const { return static_cast<int>(levels_.size()); }
+
+ private:
+  std::vector<std::vector<BlaStep>> levels_;
+};
+
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef CPU_RENDERER_HPP_
+#define CPU_RENDERER_HPP_
+
+#include <memory>
+
+#include "kernels.hpp"
+#include "renderer.hpp"
+#include "tile_scheduler.hpp"
+
+
+// Evaluates the Mandelbrot iteration field on the CPU. The image is cut into
+// square tiles which are balanced across threads by a work-stealing
+// TileScheduler; each tile is computed row by row with the widest SIMD
+// kernel the machine supports. Once the view needs it, the double-double
+// kernels take over from the double ones.
+//
+// With subdivision on, a tile is instead refined Mariani-Silver style: once
+// the border of a rectangle is known and all its pixels share one count,
+// the inside is filled with that count without being computed. Otherwise
+// the rectangle is split in four along a computed middle row and column.
+// All rectangles of a tile are refined a level at a time, so that the
+// pixels each level needs go through the SIMD kernel together.
+// This is exact unless a filament slips into a rectangle without touching
+// its border, which verify mode measures against a brute-force render.
+class CpuRenderer : public Renderer {
+ public:
+  struct SubdivisionStats {
+    long computed_pixels = 0;
+    long skipped_pixels = 0;
+    // Pixels whose filled count differs from brute force; verify mode only.
+    long mismatched_pixels = 0;
+  };
+
+  explicit CpuRenderer(int num_threads = 0, Isa isa = DetectIsa());
+  // Runs on a scheduler shared with other renderers; it must outlive this.
+  explicit CpuRenderer(TileScheduler&, Isa isa = DetectIsa());
+
+  void Render(const View&, IterationBuffer&) override;
+
+  Isa isa() const { return isa_; }
+  TileScheduler& scheduler() { return *scheduler_; }
+
+  // Cardioid/bulb test and cycle detection; on by default. Turning them off
+  // iterates every pixel to the end, for benchmarks and cross-checks.
+  bool interior_checks() const { return interior_checks_; }
+  void set_interior_checks(bool);
+
+  bool subdivision() const { return subdivision_; }
+  void set_subdivision(bool enabled) { subdivision_ = enabled; }
+  // Renders every subdivided frame a second time by brute force.
+  bool verify() const { return verify_; }
+  void set_verify(bool enabled) { verify_ = enabled; }
+  // Of the last subdivided frame.
+  const SubdivisionStats& subdivision_stats() const { return stats_; }
+
+ private:
+  void RenderSubdivided(const View&, IterationBuffer&);
+  long RefineTile(const View&, IterationBuffer&, const Tile&) const;
+
+  std::unique_ptr<TileScheduler> own_scheduler_;
+  TileScheduler* scheduler_;
+  Isa isa_;
+  bool interior_checks_ = true;
+  bool subdivision_ = false;
+  bool verify_ = false;
+  SubdivisionStats stats_;
+  MandelbrotRowKernel kernel_;
+  MandelbrotPointsKernel points_kernel_;
+  MandelbrotRowKernel dd_kernel_;
+  MandelbrotPointsKernel dd_points_kernel_;
+};
+
+
+#endif
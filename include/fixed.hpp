@@ -0,0 +1,70 @@
+#ifndef FIXED_HPP_
+#define FIXED_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// A signed fixed-point number with one 32-bit integer limb and a
+// configurable number of 32-bit fraction limbs. Magnitudes are stored
+// little-endian, so limbs_.back() holds the integer part. Results of
+// binary operations carry the larger precision of the two operands; the
+// integer part silently wraps, which is fine for Mandelbrot orbits that
+// never leave |z| < 2^31. Multiplication switches from schoolbook to
+// Karatsuba for long operands, and squaring has its own cheaper path.
+class Fixed {
+ public:
+  Fixed() : Fixed(0.0, 2) {}
+  Fixed(double, int frac_limbs);
+
+  // Parses a decimal number such as "-0.7436438870371587" or "1.25e-40".
+  // False, leaving *result as it was, for anything else and for numbers
+  // whose integer part does not fit in 32 bits.
+  static bool Parse(const std::string&, int frac_limbs, Fixed* result);
+  // Parse() that reads whatever it rejects as zero.
+  static Fixed FromString(const std::string&, int frac_limbs);
+  static int LimbsForBits(int bits) { return (bits + 31)/32; }
+
+  double ToDouble() const;
+  // The value as the unevaluated sum hi + lo of two doubles.
+  void ToDoubleDouble(double* hi, double* lo) const;
+  std::string ToString(int digits) const;
+
+  int frac_limbs() const { return static_cast<int>(limbs_.size()) - 1; }
+  int precision() const { return 32*frac_limbs(); }
+  void SetPrecision(int frac_limbs);
+  bool is_zero() const;
+
+  friend Fixed operator+(const Fixed&, const Fixed&);
+  friend Fixed operator-(const Fixed&, const Fixed&);
+  friend Fixed operator*(const Fixed&, const Fixed&);
+  friend Fixed Square(const Fixed&);
+  friend Fixed operator-(Fixed);
+  friend bool operator==(const Fixed&, const Fixed&);
+  friend bool operator!=(const Fixed& a, const Fixed& b) { return !(a == b); }
+  Fixed& operator+=(const Fixed& o) { return *this = *this + o; }
+
+ private:
+  bool negative_ = false;
+  std::vector<uint32_t> limbs_;
+};
+
+
+// A point of the complex plane at arbitrary precision.
+struct BigComplex {
+  Fixed x;
+  Fixed y;
+
+  void SetPrecision(int frac_limbs) {
+    x.SetPrecision(frac_limbs);
+    y.SetPrecision(frac_limbs);
+  }
+
+  friend bool operator==(const BigComplex& a, const BigComplex& b) {
+    return a.x == b.x && a.y == b.y;
+  }
+};
+
+
+#endif
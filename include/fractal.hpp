@@ -1,14 +1,26 @@
 #ifndef FRACTAL_HPP_
 #define FRACTAL_HPP_
 
+#include <fstream>
 #include <memory>
+#include <string>
 #include <vector>
 #include <map>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "fixed.hpp"
+#include "gpu_timer.hpp"
+#include "max_iter_governor.hpp"
+#include "polynomial.hpp"
+#include "polynomial_buffer.hpp"
+#include "precision.hpp"
+#include "profiler.hpp"
+#include "reference_orbit.hpp"
+#include "session.hpp"
 #include "shader.hpp"
+#include "view.hpp"
 
 
 class Fractal {
@@ -20,40 +32,196 @@ class Fractal {
   void HandleInput();
   bool ShouldClose() const;
 
+  // Writes every input event from now on to `path`.
+  bool StartRecording(const std::string& path);
+  // Feeds recorded events back with a fixed time step instead of the
+  // clock, drawing as fast as possible, then prints frame statistics. Live
+  // input is ignored meanwhile, and max_iter follows the recorded values
+  // rather than the governor, whose choices depend on timing.
+  void Replay(const std::vector<InputEvent>&, double dt);
+
+  // Called by the GLFW callbacks.
+  void OnEvent(InputEvent);
+
   void CursorPosCallback(double, double);
   void MouseButtonCallback(int, int, int);
   void WindowSizeCallback(int, int);
   void ScrollCallback(double, double);
   void KeyCallback(int, int, int, int);
+  void WindowRefreshCallback();
 
  private:
+  // Handles for the uniforms PushView() writes every frame, resolved when
+  // the active shader changes.
+  struct ViewUniforms {
+    Uniform<int> window_width;
+    Uniform<int> window_height;
+    Uniform<glm::dvec2> fractal_center;
+    Uniform<glm::dvec2> fractal_center_lo;
+    Uniform<double> fractal_width;
+    Uniform<double> fractal_height;
+    Uniform<int> max_iter;
+    Uniform<int> orbit_length;
+    // The GL 3.3 shaders get the view in floats instead.
+    Uniform<glm::vec2> float_center;
+    Uniform<glm::vec2> float_center_lo;
+    Uniform<glm::vec2> float_size;
+  };
+
+  // The same for the colour shader, resolved once in LoadShaders().
+  struct ColorUniforms {
+    Uniform<int> window_width;
+    Uniform<int> window_height;
+    Uniform<int> frame_width;
+    Uniform<int> frame_height;
+    Uniform<int> max_iter;
+    Uniform<int> coloring;
+    Uniform<int> num_roots;
+    Uniform<int> palette;
+    Uniform<int> smooth_coloring;
+    Uniform<float> color_density;
+    Uniform<float> palette_offset;
+    Uniform<int> precision_overlay;
+  };
+
+  // An iteration pass the max_iter governor has yet to hear about. A
+  // subsample of what it wrote is read back into pixel_buffer, and its GPU
+  // time comes from iteration_timer_ in the same order.
+  struct FrameProbe {
+    unsigned int pixel_buffer = 0;
+    GLsync fence = nullptr;
+    int max_iter = 0;
+    long pixels = 0;
+    bool newton = false;
+  };
+
   void CreateWindow();
   void CreateFractalRect();
   void LoadTextures();
   void LoadShaders();
-  double fractal_width() const;
-  double fractal_height() const;
-  glm::dvec2 fractal_center() const;
-  glm::dvec2 window_size() const;
+  void CreateOrbitBuffer();
+  void CreatePolynomialBuffer();
+  void SetPolynomial(const Polynomial&);
+  void CreateFrameBuffer();
+  void CreateProbes();
+  void ResizeFrameBuffer();
+  void UseShader(const std::string&);
+  void SetDeepMode(bool);
+  void UpdatePrecision();
+  void UpdateOrbit();
+  void FindReference();
+  void PushView(const View&, int divisor) const;
+  void UpdateResolution(double dt, bool zooming);
+  bool SnapToLastFrame(View&, glm::ivec2* shift) const;
+  void RenderFrame(const View&);
+  bool BeginProbe();
+  void EndProbe(const View&, int width, int height);
+  void UpdateMaxIter();
+  IterationStats ReadProbe(const FrameProbe&) const;
+  void ReprojectFrame(const View&, glm::ivec2 shift);
+  void ColorFrame();
+  bool Moving() const;
+  bool Zooming() const;
+  void PrintFrameStats() const;
+  void HandleEvent(const InputEvent&);
+  double Now() const;
+  void SetProfiling(bool);
+  void UpdateTitle();
   glm::dvec2 cursor_pos() const;
-  double aspect_ratio() const;
-  int max_iter() const;
-  glm::dvec2 PixelToWorld(glm::dvec2) const;
-  glm::dvec2 PixelToWorldDelta(glm::dvec2) const;
 
   GLFWwindow* window_;
   unsigned int fractal_vao_;
-  Shader* shader_;
+  Shader* shader_ = nullptr;
+  // "mandelbrot", "newton" or "perturbation". The first two run their
+  // "_float", plain or "_dd" shader, whichever is the cheapest one that
+  // ChoosePrecision() allows for the view, and Mandelbrot goes on into deep
+  // mode past double-double.
+  std::string fractal_ = "mandelbrot";
+  Precision precision_ = Precision::kDouble;
+  // The fractal shader_ was picked for; with precision_ it tells
+  // UpdatePrecision() whether shader_ needs to change.
+  std::string shader_fractal_;
+  // Toggled with D: Mandelbrot runs "mandelbrot_df" where double-float
+  // suffices rather than double, which many GPUs run far slower than float.
+  // Off by default; the shader needs GL_ARB_gpu_shader5 for `precise`.
+  bool double_float_ = false;
+  bool double_float_supported_ = false;
+  // Toggled with O: the colour pass marks the active precision in the top
+  // left corner and the window title names it.
+  bool precision_overlay_ = false;
   std::map<std::string, std::unique_ptr<Shader>> shaders_;
+  ViewUniforms view_uniforms_;
+  // The colour pass only reads the iteration texture, so changing any of
+  // these redraws without iterating a single pixel.
+  std::unique_ptr<Shader> color_shader_;
+  ColorUniforms color_uniforms_;
+  int coloring_ = 0;
+  int palette_ = 0;
+  bool smooth_coloring_ = true;
+  bool palette_cycling_ = false;
+  float color_density_ = 1.0f;
+  float palette_offset_ = 0.0f;
+  View view_;
+  // In deep mode view_.center is relative to origin_ and the perturbation
+  // shader reads the reference orbit from a buffer texture.
+  bool deep_mode_ = false;
+  BigComplex origin_;
+  ReferenceOrbit orbit_;
+  unsigned int orbit_buffer_;
+  unsigned int orbit_texture_;
+  // The Newton shader reads coefficients and roots from a uniform block.
+  Polynomial polynomial_;
+  std::unique_ptr<PolynomialBuffer> polynomial_buffer_;
+  // The fractal shaders write smooth iteration counts and |z| into one of
+  // two RG32F textures, which a colour pass then maps onto the window. While
+  // the camera zooms they render at 1/resolution_divisor_ of the window size.
+  // The divisor follows motion_divisor_, which adapts to keep frames within
+  // budget; once the zoom stops, every further frame halves the divisor
+  // until the image is back at full resolution.
+  unsigned int iteration_fbos_[2];
+  unsigned int iteration_textures_[2];
+  int current_frame_ = 0;
+  int resolution_divisor_ = 1;
+  int motion_divisor_ = 4;
+  // A full resolution frame stays valid for as long as only the center
+  // moves. The next frame is then shifted by whole pixels and only the
+  // strips that scrolled into view are computed.
+  View last_frame_;
+  const Shader* last_shader_ = nullptr;
+  bool frame_valid_ = false;
   double zoom_momentum_ = 0.0;
   glm::dvec2 scroll_momentum_{0.0, 0.0};
   bool mouse_pressed_ = false;
+  bool left_button_down_ = false;
   bool zoom_key_held_ = false;
+  // With automatic_max_iter_ on, every full iteration pass is probed and
+  // the governor sets view_.max_iter from the results.
   bool automatic_max_iter_ = true;
+  MaxIterGovernor governor_;
+  std::unique_ptr<GpuTimer> iteration_timer_;
+  unsigned int probe_fbo_;
+  unsigned int probe_texture_;
+  FrameProbe probes_[GpuTimer::kQueries];
+  int first_probe_ = 0;
+  int num_probes_ = 0;
+  // Toggled with T. Reports go to stdout and a summary to the window title.
+  Profiler profiler_;
   double time_;
   glm::dvec2 cursor_world_pos_;
   glm::dvec2 cursor_pixel_pos_;
   bool should_close_ = false;
+  // Frames are only drawn while the view moves or after something marked
+  // it dirty; otherwise HandleInput() sleeps until the next event.
+  bool dirty_ = true;
+  long frames_drawn_ = 0;
+  long pixels_computed_ = 0;
+  double idle_seconds_ = 0.0;
+  double start_time_;
+  std::ofstream recording_;
+  double recording_start_ = 0.0;
+  int recorded_max_iter_ = 0;
+  bool replaying_ = false;
+  double replay_time_ = 0.0;
 };
 
 static void cursor_pos_callback(GLFWwindow*, double, double);
@@ -61,6 +229,7 @@ void mouse_button_callback(GLFWwindow* w, int, int, int);
 void window_size_callback(GLFWwindow*, int, int);
 void scroll_callback(GLFWwindow*, double, double);
 void key_callback(GLFWwindow*, int, int, int, int);
+void window_refresh_callback(GLFWwindow*);
 
 
 #endif
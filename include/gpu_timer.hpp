@@ -0,0 +1,35 @@
+#ifndef GPU_TIMER_HPP_
+#define GPU_TIMER_HPP_
+
+
+// Measures how long the GPU takes for the commands between Begin() and
+// End() with GL_TIME_ELAPSED queries. Results are read a few frames later
+// from a ring of queries, so nothing waits for the GPU; while every query
+// of the ring is still in flight, Begin() skips the measurement.
+class GpuTimer {
+ public:
+  static constexpr int kQueries = 4;
+
+  GpuTimer();
+  ~GpuTimer();
+  GpuTimer(const GpuTimer&) = delete;
+  GpuTimer& operator=(const GpuTimer&) = delete;
+
+  // Returns false if this measurement is skipped. End() may be called
+  // either way.
+  bool Begin();
+  void End();
+
+  // Takes the oldest measurement, in seconds, once the GPU has finished it.
+  bool Poll(double* seconds);
+  bool pending() const { return count_ > 0; }
+
+ private:
+  unsigned int queries_[kQueries];
+  int first_ = 0;  // Oldest query in flight.
+  int count_ = 0;  // Queries in flight.
+  bool running_ = false;
+};
+
+
+#endif
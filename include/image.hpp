@@ -0,0 +1,32 @@
+#ifndef IMAGE_HPP_
+#define IMAGE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// An 8-bit RGBA image stored top to bottom, as image files expect.
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+
+  void Resize(int w, int h) {
+    width = w;
+    height = h;
+    rgba.resize(static_cast<size_t>(w)*h*4);
+  }
+
+  uint8_t* at(int x, int y) {
+    return &rgba[(static_cast<size_t>(y)*width + x)*4];
+  }
+};
+
+
+// Writes `image` as PNG or binary PPM, chosen by the extension of `path`.
+// Returns false if the extension is unknown or the file can't be written.
+bool WriteImage(const std::string& path, const Image& image);
+
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef KERNELS_HPP_
+#define KERNELS_HPP_
+
+#include "bla.hpp"
+#include "polynomial.hpp"
+#include "reference_orbit.hpp"
+#include "view.hpp"
+
+
+// Instruction sets the CPU kernels are compiled for. The best one supported
+// by the running machine is picked at runtime.
+enum class Isa {
+  kScalar,
+  kAvx2,
+  kAvx512,
+};
+
+Isa DetectIsa();
+bool IsaSupported(Isa);
+const char* IsaName(Isa);
+
+// Writes the Mandelbrot iteration counts of pixels [x0, x1) in row y of
+// `view` to out[0 .. x1-x0). Pixel centers, the update z = z^2 + c and the
+// escape test |z|^2 < 4 are evaluated with the same operations in the same
+// order in every variant, so all of them produce identical counts.
+// Points in the main cardioid or the period-2 bulb are not iterated at all,
+// and orbits that exactly repeat the value saved at the last power-of-two
+// iteration (Brent's cycle detection) stop early. Both only ever cut short
+// pixels that would reach max_iter, so the counts are the same as without
+// these interior checks, which GetMandelbrotRowKernel() can leave out.
+using MandelbrotRowKernel = void (*)(const View&, int y, int x0, int x1,
+                                     int* out);
+
+void MandelbrotRowScalar(const View&, int y, int x0, int x1, int* out);
+void MandelbrotRowAvx2(const View&, int y, int x0, int x1, int* out);
+void MandelbrotRowAvx512(const View&, int y, int x0, int x1, int* out);
+
+MandelbrotRowKernel GetMandelbrotRowKernel(Isa, bool interior_checks = true);
+
+// The same for the n scattered pixels (x[i], y[i]), written to out[0 .. n).
+using MandelbrotPointsKernel = void (*)(const View&, int n, const int* x,
+                                        const int* y, int* out);
+
+MandelbrotPointsKernel GetMandelbrotPointsKernel(
+    Isa, bool interior_checks = true);
+
+// Perturbation counterpart of the Mandelbrot kernels. The view's center is
+// the offset of the image center from orbit.c, so the per-pixel offsets dc
+// stay representable in double at any zoom depth. Each pixel iterates
+// d_{n+1} = (2 Z_n + d_n) d_n + dc and escapes when |Z_n + d_n|^2 >= 4.
+// Glitched pixels, where |Z_n + d_n| cancelled to far below |Z_n| or which
+// outlived an escaping reference, are written as -1 - n with n the
+// iteration the glitch was noticed at. With a BlaTable, runs of steps whose
+// approximation is valid for the current offset are skipped in one go; the
+// SIMD variants skip when it is valid for every active lane.
+using PerturbationRowKernel = void (*)(const ReferenceOrbit&, const BlaTable*,
+                                       const View&, int y, int x0, int x1,
+                                       int* out);
+
+void PerturbationRowScalar(const ReferenceOrbit&, const BlaTable*,
+                           const View&, int y, int x0, int x1, int* out);
+void PerturbationRowAvx2(const ReferenceOrbit&, const BlaTable*, const View&,
+                         int y, int x0, int x1, int* out);
+void PerturbationRowAvx512(const ReferenceOrbit&, const BlaTable*,
+                           const View&, int y, int x0, int x1, int* out);
+
+PerturbationRowKernel GetPerturbationRowKernel(Isa);
+
+// Newton's method for a polynomial, started at the pixel centers of row y.
+// A pixel stops once it is within kNewtonTolerance of one of the
+// polynomial's roots or its step gets that short. The index of the root it
+// reached, or -1, goes to roots[0 .. x1-x0) and the number of steps taken
+// to steps[0 .. x1-x0); pixels that run out of steps still count for a root
+// within kNewtonRootRadius. f and f' come from one Horner pass; as with the
+// Mandelbrot kernels, all variants produce identical results.
+constexpr double kNewtonTolerance = 1e-4;
+constexpr double kNewtonRootRadius = 1e-2;
+
+using NewtonRowKernel = void (*)(const Polynomial&, const View&, int y,
+                                 int x0, int x1, int* roots, int* steps);
+
+void NewtonRowScalar(const Polynomial&, const View&, int y, int x0, int x1,
+                     int* roots, int* steps);
+void NewtonRowAvx2(const Polynomial&, const View&, int y, int x0, int x1,
+                   int* roots, int* steps);
+void NewtonRowAvx512(const Polynomial&, const View&, int y, int x0, int x1,
+                     int* roots, int* steps);
+
+NewtonRowKernel GetNewtonRowKernel(Isa);
+
+// Double-double counterparts of the Mandelbrot and Newton kernels, for views
+// where ChoosePrecision() is past double. Pixel centers are center +
+// center_lo plus the same offsets as above, and z is carried as an
+// unevaluated sum of two doubles, about 106 bits. Escape, convergence and
+// root tests only look at the high parts. Again all variants produce
+// identical results. The interior checks are cycle detection only: the
+// cardioid and bulb test is evaluated in double, which cannot place their
+// boundaries at these zooms.
+void MandelbrotDdRowScalar(const View&, int y, int x0, int x1, int* out);
+void MandelbrotDdRowAvx2(const View&, int y, int x0, int x1, int* out);
+void MandelbrotDdRowAvx512(const View&, int y, int x0, int x1, int* out);
+
+MandelbrotRowKernel GetMandelbrotDdRowKernel(Isa, bool interior_checks = true);
+MandelbrotPointsKernel GetMandelbrotDdPointsKernel(
+    Isa, bool interior_checks = true);
+
+void NewtonDdRowScalar(const Polynomial&, const View&, int y, int x0, int x1,
+                       int* roots, int* steps);
+void NewtonDdRowAvx2(const Polynomial&, const View&, int y, int x0, int x1,
+                     int* roots, int* steps);
+void NewtonDdRowAvx512(const Polynomial&, const View&, int y, int x0, int x1,
+                       int* roots, int* steps);
+
+NewtonRowKernel GetNewtonDdRowKernel(Isa);
+
+// A single pixel with offset dc from the reference, with the same result
+// encoding as the row kernels.
+int PerturbationPixel(const ReferenceOrbit&, const BlaTable*, double dcx,
+                      double dcy, int max_iter);
+
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef MAX_ITER_GOVERNOR_HPP_
+#define MAX_ITER_GOVERNOR_HPP_
+
+
+// What a sample of a frame's pixels says about its iteration limit.
+struct IterationStats {
+  long samples = 0;
+  // Samples that reached max_iter without escaping or converging.
+  long saturated = 0;
+  // Sum and largest of the counts of the other samples.
+  double escaped_sum = 0.0;
+  double escaped_max = 0.0;
+};
+
+
+// Picks max_iter from measured frames. The frame time and the iteration
+// counts give the cost of one iteration; the samples that reached the limit
+// are what raising it would make more expensive, so the budget caps how far
+// it can go. Within that cap, the limit grows while samples still escape
+// close to it or none escape at all, and shrinks towards twice the slowest
+// escape once none come close.
+// The change per frame is bounded, and small changes are ignored so that a
+// still view settles instead of being redrawn over and over.
+class MaxIterGovernor {
+ public:
+  static constexpr int kMinIter = 50;
+  static constexpr int kMaxIter = 1 << 20;
+
+  explicit MaxIterGovernor(double budget);
+
+  // Longest a full-resolution frame may take, in seconds.
+  double budget() const { return budget_; }
+  void set_budget(double seconds) { budget_ = seconds; }
+
+  // Returns the limit for the next frame. The measured frame computed
+  // `pixels` pixels with `max_iter` in `seconds`; full frames have
+  // `full_pixels`.
+  int Update(const IterationStats&, int max_iter, double seconds, long pixels,
+             long full_pixels);
+
+ private:
+  double budget_;
+  // Smoothed seconds per iteration of one pixel, or 0 before the first
+  // frame.
+  double iteration_cost_ = 0.0;
+};
+
+
+#endif
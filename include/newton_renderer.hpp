@@ -0,0 +1,46 @@
+#ifndef NEWTON_RENDERER_HPP_
+#define NEWTON_RENDERER_HPP_
+
+#include <memory>
+
+#include "kernels.hpp"
+#include "polynomial.hpp"
+#include "renderer.hpp"
+#include "tile_scheduler.hpp"
+
+
+// Newton's method for a polynomial on the CPU, matching shaders/newton.frag.
+// Instead of an iteration count every pixel holds the index of the root it
+// converged to, in the order of Polynomial::roots(), or -1 if it got nowhere
+// near any of them. A pixel stops as soon as it is within a small tolerance
+// of a root or its step becomes that short, so max_iter only bounds the
+// rare slow pixels. Deep views are computed in double-double.
+class NewtonRenderer : public Renderer {
+ public:
+  explicit NewtonRenderer(int num_threads = 0, Isa isa = DetectIsa());
+  // Runs on a scheduler shared with other renderers; it must outlive this.
+  explicit NewtonRenderer(TileScheduler&, Isa isa = DetectIsa());
+
+  void Render(const View&, IterationBuffer&) override;
+
+  // z^3 - 1 unless set otherwise.
+  const Polynomial& polynomial() const { return polynomial_; }
+  void set_polynomial(const Polynomial& p) { polynomial_ = p; }
+
+  Isa isa() const { return isa_; }
+  TileScheduler& scheduler() { return *scheduler_; }
+  // Newton steps each pixel of the last frame took to converge, for shading.
+  const IterationBuffer& steps() const { return steps_; }
+
+ private:
+  std::unique_ptr<TileScheduler> own_scheduler_;
+  TileScheduler* scheduler_;
+  Isa isa_;
+  NewtonRowKernel kernel_;
+  NewtonRowKernel dd_kernel_;
+  Polynomial polynomial_;
+  IterationBuffer steps_;
+};
+
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef OFFSCREEN_HPP_
+#define OFFSCREEN_HPP_
+
+#include <memory>
+#include <string>
+
+#include "cpu_renderer.hpp"
+#include "image.hpp"
+#include "newton_renderer.hpp"
+#include "palette.hpp"
+#include "perturbation_renderer.hpp"
+
+
+enum class FractalType { kMandelbrot, kNewton, kDeep };
+
+// "mandelbrot", "newton" or "deep".
+bool ParseFractalType(const std::string&, FractalType*);
+const char* FractalTypeName(FractalType);
+
+// Whether `s` can be a coordinate of an ImageJob's center: a number that
+// strtod() reads to the end and Fixed::Parse() accepts.
+bool IsCoordinate(const std::string& s);
+
+
+// One image to render without a window. The center is kept as decimal text
+// so that deep views don't lose digits to double.
+struct ImageJob {
+  FractalType type = FractalType::kMandelbrot;
+  std::string center_x = "0";
+  std::string center_y = "0";
+  double width = 2.0;
+  int max_iter = 500;
+  int pixel_width = 600;
+  int pixel_height = 600;
+  Polynomial polynomial;  // Only for kNewton.
+  // Only for kMandelbrot: fill uniform rectangles instead of computing them,
+  // see CpuRenderer.
+  bool subdivide = false;
+};
+
+// The view a job describes, with the center read to double-double
+// precision.
+View JobView(const ImageJob&);
+
+
+// Renders images on the CPU backends and colours them like the shaders do,
+// without creating a window or GL context. All backends share one
+// TileScheduler; they are created on first use and kept, so consecutive
+// jobs reuse the same threads, buffers and reference orbits.
+class OffscreenRenderer {
+ public:
+  explicit OffscreenRenderer(int num_threads = 0);
+
+  bool LoadPalette(const std::string& path) { return palette_.Load(path); }
+  void Render(const ImageJob&, Image&);
+
+  TileScheduler& scheduler() { return scheduler_; }
+
+ private:
+  void Colorize(const ImageJob&, Image&) const;
+
+  TileScheduler scheduler_;
+  std::unique_ptr<CpuRenderer> mandelbrot_;
+  std::unique_ptr<NewtonRenderer> newton_;
+  std::unique_ptr<PerturbationRenderer> deep_;
+  Palette palette_;
+  IterationBuffer iterations_;
+};
+
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef PALETTE_HPP_
+#define PALETTE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+using Rgb = std::array<uint8_t, 3>;
+
+
+// A colour ramp read from one of the palette images in textures/, sampled
+// the way the shaders sample it as a GL_REPEAT, GL_LINEAR 1D texture. Until
+// Load() succeeds it is a plain black to white ramp.
+class Palette {
+ public:
+  Palette();
+
+  // Reads the first row of an image file. Returns false and keeps the
+  // current colours if the file can't be read.
+  bool Load(const std::string& path);
+
+  Rgb Sample(double t) const;
+
+ private:
+  std::vector<Rgb> colors_;
+};
+
+
+#endif
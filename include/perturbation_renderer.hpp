@@ -0,0 +1,67 @@
+#ifndef PERTURBATION_RENDERER_HPP_
+#define PERTURBATION_RENDERER_HPP_
+
+#include <memory>
+
+#include "bla.hpp"
+#include "fixed.hpp"
+#include "kernels.hpp"
+#include "reference_orbit.hpp"
+#include "renderer.hpp"
+#include "tile_scheduler.hpp"
+
+
+// Deep zoom Mandelbrot backend. A single reference orbit at the origin is
+// iterated at high precision; every pixel then only iterates its offset
+// from that orbit in double. The center of the View passed to Render() is
+// interpreted relative to origin(). Unless disabled, a BlaTable built from
+// the orbit lets pixels skip long runs of iterations.
+//
+// Pixels the kernels flag as glitched are grouped into connected regions;
+// each region gets a secondary reference near its centroid and only its
+// pixels are iterated again. Whatever is still glitched once the reference
+// budget is spent keeps the count the kernel gave up at.
+class PerturbationRenderer : public Renderer {
+ public:
+  explicit PerturbationRenderer(int num_threads = 0, Isa isa = DetectIsa());
+  // Runs on a scheduler shared with other renderers; it must outlive this.
+  explicit PerturbationRenderer(TileScheduler&, Isa isa = DetectIsa());
+
+  void Render(const View&, IterationBuffer&) override;
+
+  const BigComplex& origin() const { return origin_; }
+  void set_origin(const BigComplex& origin) { origin_ = origin; }
+  const ReferenceOrbit& orbit() const { return orbit_; }
+  bool use_bla() const { return use_bla_; }
+  void set_use_bla(bool use_bla) { use_bla_ = use_bla; }
+  bool correct_glitches() const { return correct_glitches_; }
+  void set_correct_glitches(bool correct) { correct_glitches_ = correct; }
+  TileScheduler& scheduler() { return *scheduler_; }
+
+  struct GlitchStats {
+    long glitched_pixels = 0;
+    int references = 0;
+    long unresolved_pixels = 0;
+  };
+  // Of the last Render().
+  const GlitchStats& glitch_stats() const { return glitch_stats_; }
+
+  static constexpr int kMaxReferences = 64;
+
+ private:
+  void CorrectGlitches(const View&, IterationBuffer&);
+
+
+  std::unique_ptr<TileScheduler> own_scheduler_;
+  TileScheduler* scheduler_;
+  PerturbationRowKernel kernel_;
+  BigComplex origin_;
+  ReferenceOrbit orbit_;
+  BlaTable bla_;
+  bool use_bla_ = true;
+  bool correct_glitches_ = true;
+  GlitchStats glitch_stats_;
+};
+
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef POLYNOMIAL_HPP_
+#define POLYNOMIAL_HPP_
+
+#include <complex>
+#include <string>
+#include <vector>
+
+
+// A complex polynomial c_0 + c_1 z + ... + c_n z^n for the Newton fractal,
+// with its roots found once up front by the Durand-Kerner method. Roots are
+// ordered by their argument in [0, 2 pi), so z^3 - 1 keeps the order 1,
+// e^(2 pi i/3), e^(-2 pi i/3) of the original hard-coded shader.
+class Polynomial {
+ public:
+  // The shaders hold coefficients and roots in fixed-size arrays.
+  static constexpr int kMaxDegree = 16;
+
+  // z^3 - 1.
+  Polynomial() : Polynomial(UnitRoots(3)) {}
+  // coefficients[k] multiplies z^k. Leading zeros are dropped; the degree
+  // must end up between 1 and kMaxDegree.
+  explicit Polynomial(std::vector<std::complex<double>> coefficients);
+
+  // z^n - 1.
+  static Polynomial UnitRoots(int degree);
+
+  int degree() const { return static_cast<int>(coefficients_.size()) - 1; }
+  const std::vector<std::complex<double>>& coefficients() const {
+    return coefficients_;
+  }
+  const std::vector<std::complex<double>>& roots() const { return roots_; }
+
+  // f(z) and f'(z) in a single Horner pass.
+  void Evaluate(std::complex<double> z, std::complex<double>* f,
+                std::complex<double>* df) const;
+
+ private:
+  void FindRoots();
+
+  std::vector<std::complex<double>> coefficients_;
+  std::vector<std::complex<double>> roots_;
+};
+
+
+// Parses a coefficient list with the highest power first, separated by
+// commas or spaces, e.g. "1 0 0 -1" for z^3 - 1. Each coefficient is a
+// real number, an imaginary one like "2i" or "-i", or a sum like "1-0.5i".
+bool ParsePolynomial(const std::string&, Polynomial*);
+
+
+#endif
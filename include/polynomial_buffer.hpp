@@ -0,0 +1,28 @@
+#ifndef POLYNOMIAL_BUFFER_HPP_
+#define POLYNOMIAL_BUFFER_HPP_
+
+#include "polynomial.hpp"
+
+
+// The uniform buffer behind the Newton shaders' Polynomial block, bound to
+// binding point kBinding. Shared by the viewer and the GPU benchmark so
+// that there is one copy of the block's std140 layout to keep in sync
+// with newton.frag.
+class PolynomialBuffer {
+ public:
+  static constexpr unsigned int kBinding = 0;
+
+  PolynomialBuffer();
+  ~PolynomialBuffer();
+  PolynomialBuffer(const PolynomialBuffer&) = delete;
+  PolynomialBuffer& operator=(const PolynomialBuffer&) = delete;
+
+  // Writes the coefficients and roots of `polynomial`.
+  void Upload(const Polynomial& polynomial) const;
+
+ private:
+  unsigned int buffer_ = 0;
+};
+
+
+#endif
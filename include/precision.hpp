@@ -0,0 +1,36 @@
+#ifndef PRECISION_HPP_
+#define PRECISION_HPP_
+
+#include "view.hpp"
+
+
+// The numeric types a view can be iterated in, from the fewest bits up.
+// Double-float is a pair of floats, about 48 bits, for GPUs that run double
+// slowly.
+enum class Precision {
+  kFloat,
+  kDoubleFloat,
+  kDouble,
+  kDoubleDouble,
+  kPerturbation,
+};
+
+const char* PrecisionName(Precision);
+
+// The cheapest precision that still tells neighbouring pixels of `view`
+// apart: one whose pixel spacing spans at least kUlpsPerPixel units in the
+// last place of the largest center coordinate (or of 1, near the origin).
+// For float and double-float the spacing must span that many times
+// max_iter, as their rounding errors add up over the iterations. Past
+// double-double only perturbation around a reference orbit is exact.
+// Double-float is only considered if `double_float` is set.
+Precision ChoosePrecision(const View&, bool double_float = false);
+
+constexpr double kUlpsPerPixel = 16.0;
+
+// Splits `v` into the double-float pair hi + lo that the double-float
+// shader takes its center as.
+void SplitToFloats(glm::dvec2 v, glm::vec2* hi, glm::vec2* lo);
+
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gpu_timer.hpp"
+
+
+// The last kWindow samples of a duration.
+class RollingStats {
+ public:
+  static constexpr int kWindow = 240;
+
+  void Add(double seconds);
+  void Clear() { count_ = 0; }
+
+  int count() const { return count_; }
+  double Mean() const;
+  // p in [0, 1], by the nearest rank.
+  double Percentile(double p) const;
+
+ private:
+  std::array<double, kWindow> samples_;
+  int next_ = 0;
+  int count_ = 0;
+};
+
+
+// Per-pass timings of the viewer while it is enabled. GPU passes are timed
+// with a GpuTimer each, so their results come in a few frames late and
+// reading them never stalls; CPU passes are timed with ScopedTimer. Passes
+// are created on first use and reported in that order.
+class Profiler {
+ public:
+  bool enabled() const { return enabled_; }
+  // Disabling drops the collected statistics.
+  void set_enabled(bool);
+
+  // GPU time of the commands issued between the two calls. Passes must not
+  // overlap, as only one GL_TIME_ELAPSED query can be active at a time.
+  void BeginGpu(const std::string& pass);
+  void EndGpu(const std::string& pass);
+  // For GPU times measured by someone else's timer.
+  void AddGpuSample(const std::string& pass, double seconds);
+  void AddCpuSample(const std::string& pass, double seconds);
+
+  // Collects the GPU timings that have finished. Returns true about once a
+  // second, when a new report is due.
+  bool EndFrame(double now);
+
+  // Mean frame and per-pass GPU times on one line, for the window title.
+  std::string Summary() const;
+  // Mean, percentiles and worst time of every pass.
+  void PrintReport(std::ostream&) const;
+
+ private:
+  struct Pass {
+    std::string name;
+    bool gpu;
+    std::unique_ptr<GpuTimer> timer;
+    RollingStats stats;
+  };
+
+  Pass& Find(const std::string& name, bool gpu);
+
+  bool enabled_ = false;
+  double last_report_ = 0.0;
+  std::vector<Pass> passes_;
+};
+
+
+// Adds the time until it goes out of scope to a CPU pass, if the profiler
+// is enabled.
+class ScopedTimer {
+ public:
+  ScopedTimer(Profiler&, const char* pass);
+  ~ScopedTimer();
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Profiler* profiler_;
+  const char* pass_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef REFERENCE_ORBIT_HPP_
+#define REFERENCE_ORBIT_HPP_
+
+#include <vector>
+
+#include "fixed.hpp"
+#include "view.hpp"
+
+
+#ifdef FRACTAL_HAVE_GMP
+constexpr bool kHaveGmp = true;
+#else
+constexpr bool kHaveGmp = false;
+#endif
+
+
+// The Mandelbrot orbit Z_0 = 0, Z_{n+1} = Z_n^2 + C of a reference point C,
+// iterated at high precision and rounded to double for use by the
+// perturbation kernels. The orbit stops at the first Z_n with |Z_n| >= 2
+// or at Z_max_iter, whichever comes first.
+struct ReferenceOrbit {
+  BigComplex c;
+  int precision = 0;
+  int max_iter = 0;
+  bool escaped = false;
+  std::vector<double> re;
+  std::vector<double> im;
+  // Iterate with GMP instead of Fixed. Only honoured if the build found it.
+  bool use_gmp = kHaveGmp;
+
+  int length() const { return static_cast<int>(re.size()); }
+
+  void Compute(const BigComplex& c, int precision, int max_iter);
+
+  // Recomputes the orbit if it belongs to a different point, was computed
+  // with too few bits or is too short for `view`. Returns true if it did.
+  bool Update(const BigComplex& c, const View& view);
+
+ private:
+  void ComputeFixed(const BigComplex& c);
+  void ComputeGmp(const BigComplex& c);
+};
+
+
+// Fraction bits needed to tell neighbouring pixels of `view` apart, with
+// enough headroom for rounding errors to stay well below a pixel.
+int RequiredPrecision(const View&);
+
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef RENDER_JOBS_HPP_
+#define RENDER_JOBS_HPP_
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "offscreen.hpp"
+
+
+// An image to render and the file to write it to.
+struct RenderJob {
+  ImageJob image;
+  std::string output;
+};
+
+
+// Reads a job list in one of two formats, told apart by the first line:
+// JSON lines with one flat object per line, or CSV with a header row. Both
+// use the keys fractal, x, y, width, max_iter, pixel_width, pixel_height,
+// polynomial, subdivide (0 or 1) and output; only output is required, the
+// rest default to ImageJob's values. Blank lines and lines starting with
+// '#' are skipped. Returns false with a message naming the offending line
+// on malformed input.
+bool ReadRenderJobs(std::istream&, std::vector<RenderJob>*,
+                    std::string* error);
+
+
+#endif
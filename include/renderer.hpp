@@ -0,0 +1,35 @@
+#ifndef RENDERER_HPP_
+#define RENDERER_HPP_
+
+#include <vector>
+
+#include "view.hpp"
+
+
+// Per-pixel escape iteration counts. Rows are stored bottom to top so that
+// pixel (x, y) matches gl_FragCoord in the fragment shaders.
+struct IterationBuffer {
+  int width = 0;
+  int height = 0;
+  std::vector<int> data;
+
+  void Resize(int w, int h) {
+    width = w;
+    height = h;
+    data.resize(static_cast<size_t>(w)*h);
+  }
+
+  int& at(int x, int y) { return data[static_cast<size_t>(y)*width + x]; }
+  int at(int x, int y) const { return data[static_cast<size_t>(y)*width + x]; }
+};
+
+
+// A backend that evaluates the iteration field of a fractal for a view.
+class Renderer {
+ public:
+  virtual ~Renderer() = default;
+  virtual void Render(const View&, IterationBuffer&) = 0;
+};
+
+
+#endif
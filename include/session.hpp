@@ -0,0 +1,41 @@
+#ifndef SESSION_HPP_
+#define SESSION_HPP_
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+// One GLFW callback of an interactive session, or a change of max_iter,
+// at `time` seconds since the session started.
+struct InputEvent {
+  enum class Type {
+    kCursorPos,    // x, y
+    kMouseButton,  // args: button, action, mods
+    kWindowSize,   // args: width, height
+    kScroll,       // x, y: offsets
+    kKey,          // args: key, scancode, action, mods
+    kRefresh,
+    kMaxIter,      // args: max_iter
+  };
+
+  Type type = Type::kRefresh;
+  double time = 0.0;
+  double x = 0.0;
+  double y = 0.0;
+  int args[4] = {};
+};
+
+
+// Sessions are text with one event per line, e.g. "1.250000 scroll 0 1",
+// after a "# fractal session" comment line.
+void WriteSessionHeader(std::ostream&);
+void WriteInputEvent(std::ostream&, const InputEvent&);
+
+// Blank lines and lines starting with '#' are skipped. Returns false with
+// a message naming the offending line on malformed input.
+bool ReadSession(std::istream&, std::vector<InputEvent>*, std::string* error);
+
+
+#endif
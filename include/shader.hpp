@@ -3,21 +3,59 @@
 
 
 #include <string>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 
+// A uniform location resolved once from a linked program. Setting a value
+// through a handle involves no name lookup. A location of -1 is silently
+// ignored by GL, so handles for uniforms a shader lacks are harmless.
+template <typename T>
+struct Uniform {
+  int location = -1;
+};
+
+
 class Shader {
  public:
   unsigned int id;
 
   Shader(const char* vertex_path, const char* fragment_path);
   void Use() const;
-  void SetUniform(std::string, double) const;
-  void SetUniform(std::string, glm::dvec2) const;
-  void SetUniform(std::string, int) const;
+  int UniformLocation(const std::string&) const;
+
+  template <typename T>
+  Uniform<T> GetUniform(const std::string& name) const {
+    return {UniformLocation(name)};
+  }
+
+  void SetUniform(const std::string&, double) const;
+  void SetUniform(const std::string&, glm::dvec2) const;
+  void SetUniform(const std::string&, float) const;
+  void SetUniform(const std::string&, glm::vec2) const;
+  void SetUniform(const std::string&, int) const;
+  void SetUniform(Uniform<double>, double) const;
+  void SetUniform(Uniform<glm::dvec2>, glm::dvec2) const;
+  void SetUniform(Uniform<float>, float) const;
+  void SetUniform(Uniform<glm::vec2>, glm::vec2) const;
+  void SetUniform(Uniform<int>, int) const;
+
+  // Points the named uniform block at a GL_UNIFORM_BUFFER binding point.
+  // Does nothing if the shader has no such block.
+  void BindUniformBlock(const std::string&, unsigned int binding) const;
+
+ private:
+  void CacheUniformLocations();
+
+  std::unordered_map<std::string, int> uniform_locations_;
 };
 
 
+// Whether the current context advertises the named GL extension, e.g.
+// "GL_ARB_gpu_shader5".
+bool HasGlExtension(const std::string&);
+
+
 #endif
@@ -0,0 +1,78 @@
+#ifndef TILE_SCHEDULER_HPP_
+#define TILE_SCHEDULER_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// A rectangle of pixels [x0, x1) x [y0, y1).
+struct Tile {
+  int x0, y0, x1, y1;
+};
+
+
+struct WorkerStats {
+  long tiles_run = 0;
+  long tiles_stolen = 0;
+  double busy_seconds = 0.0;
+  double idle_seconds = 0.0;
+};
+
+
+// Splits an image into square tiles and runs them on a set of workers. Each
+// worker starts with a contiguous block of tiles in its own deque, takes
+// work from the front of it and, once it runs dry, steals from the back of
+// the other workers' deques. The calling thread acts as worker 0.
+class TileScheduler {
+ public:
+  explicit TileScheduler(int num_threads = 0);
+  ~TileScheduler();
+
+  TileScheduler(const TileScheduler&) = delete;
+  TileScheduler& operator=(const TileScheduler&) = delete;
+
+  void Run(int width, int height, const std::function<void(const Tile&)>&);
+
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+  int tile_size() const { return tile_size_; }
+  void set_tile_size(int size) { tile_size_ = size > 0 ? size : 1; }
+
+  // Statistics accumulated over all runs since the last reset.
+  std::vector<WorkerStats> stats() const;
+  void ResetStats();
+  void PrintStats() const;
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Tile> tiles;
+    WorkerStats stats;
+    // Time spent on tiles in the current run.
+    double run_busy_seconds = 0.0;
+    std::thread thread;
+  };
+
+  void ThreadLoop(int index);
+  void Work(int index);
+  bool Pop(int index, Tile&);
+  bool Steal(int index, Tile&);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  int tile_size_ = 64;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(const Tile&)>* task_ = nullptr;
+  int finished_ = 0;
+  unsigned long generation_ = 0;
+  bool stop_ = false;
+};
+
+
+#endif
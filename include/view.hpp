@@ -0,0 +1,59 @@
+#ifndef VIEW_HPP_
+#define VIEW_HPP_
+
+#include <glm/glm.hpp>
+
+
+// The visible region of the complex plane together with the pixel grid it is
+// sampled on. Fractal keeps this on the CPU as the single source of truth and
+// pushes it to the active shader once per frame.
+struct View {
+  // The center is the unevaluated sum center + center_lo, which the
+  // double-double kernels read to about 106 bits. Everything else only
+  // looks at center.
+  glm::dvec2 center{0.0, 0.0};
+  glm::dvec2 center_lo{0.0, 0.0};
+  double height = 2.0;
+  int max_iter = 50;
+  int pixel_width = 600;
+  int pixel_height = 600;
+
+  double aspect_ratio() const {
+    return static_cast<double>(pixel_width)/pixel_height;
+  }
+
+  double width() const {
+    return height*aspect_ratio();
+  }
+
+  glm::dvec2 PixelToWorld(glm::dvec2 p) const {
+    return center + PixelToOffset(p);
+  }
+
+  // The offset of pixel p from the center.
+  glm::dvec2 PixelToOffset(glm::dvec2 p) const {
+    const double px = p.x/pixel_width;
+    const double py = p.y/pixel_height;
+    return {(px-0.5)*width(), (0.5-py)*height};
+  }
+
+  glm::dvec2 PixelToWorldDelta(glm::dvec2 p) const {
+    const double px = p.x/pixel_width;
+    const double py = p.y/pixel_height;
+    return {px*width(), -py*height};
+  }
+
+  // Moves the center by `delta`, keeping the rounding error of the sum in
+  // center_lo (Knuth's two-sum) so that small steps at deep zooms add up.
+  void Move(glm::dvec2 delta) {
+    const glm::dvec2 sum = center + delta;
+    const glm::dvec2 b = sum - center;
+    const glm::dvec2 error = (center - (sum - b)) + (delta - b);
+    const glm::dvec2 lo = center_lo + error;
+    center = sum + lo;
+    center_lo = lo - (center - sum);
+  }
+};
+
+
+#endif
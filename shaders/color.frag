@@ -0,0 +1,82 @@
+#version 330 core
+
+out vec4 frag_color;
+
+uniform int window_width;
+uniform int window_height;
+uniform int frame_width;  // Part of `iterations` written by the last pass.
+uniform int frame_height;
+uniform sampler2D iterations;  // Smooth iteration count and |z| per pixel.
+uniform sampler1D pal0;
+uniform sampler1D pal1;
+uniform int max_iter;
+uniform int coloring;  // 0: iteration count through a palette, 1: Newton root.
+uniform int num_roots;
+uniform int palette;
+uniform int smooth_coloring;
+uniform float color_density;
+uniform float palette_offset;
+// Index of the active Precision, or -1 for no overlay.
+uniform int precision_overlay;
+
+// One square per precision in the top left corner: float, double-float,
+// double, double-double and perturbation. The active one is lit.
+const int num_precisions = 5;
+const vec3 precision_colors[num_precisions] = vec3[](
+    vec3(0.2, 0.8, 0.2), vec3(0.1, 0.8, 0.8), vec3(0.2, 0.4, 1.0),
+    vec3(1.0, 0.6, 0.1), vec3(0.9, 0.1, 0.1));
+const int square_size = 12;
+const int square_spacing = 16;
+
+
+bool draw_overlay() {
+  ivec2 p = ivec2(gl_FragCoord.x, window_height - gl_FragCoord.y) - 8;
+  if (p.x < 0 || p.y < 0 || p.y >= square_size ||
+      p.x % square_spacing >= square_size) {
+    return false;
+  }
+  int square = p.x/square_spacing;
+  if (square >= num_precisions) {
+    return false;
+  }
+  vec3 color = precision_colors[square];
+  frag_color = vec4(square == precision_overlay ? color : 0.25*color, 1.0);
+  return true;
+}
+
+
+void main() {
+  if (precision_overlay >= 0 && draw_overlay()) {
+    return;
+  }
+
+  vec2 size = textureSize(iterations, 0);
+  vec2 uv = gl_FragCoord.xy/vec2(window_width, window_height)
+          * vec2(frame_width, frame_height)/size;
+
+  if (coloring == 1) {
+    // Root indices must not be interpolated.
+    vec2 value = texelFetch(iterations, ivec2(uv*size), 0).rg;
+    int root = int(value.x);
+    // Root i of n gets the fully saturated hue i/n, so the roots of z^3 - 1
+    // are red, green and blue. Pixels that found no root are white.
+    vec3 color = vec3(1.0);
+    if (root >= 0) {
+      vec3 k = mod(vec3(5.0, 3.0, 1.0) + 6.0*root/float(num_roots), 6.0);
+      color = 1.0 - clamp(min(k, 4.0 - k), 0.0, 1.0);
+    }
+    // Darker the more steps the pixel needed to converge.
+    float shade = 0.25 + 0.75*exp(-0.1*value.y*color_density);
+    frag_color = vec4(color*shade, 1.0);
+    return;
+  }
+
+  vec2 value = texture(iterations, uv).rg;
+  float iter = value.x;
+  if (smooth_coloring == 0 && value.y >= 2.0) {
+    // Undo the smoothing with the stored |z|.
+    iter = round(iter - 1 + log2(log(value.y)));
+  }
+  float t = iter/float(max_iter)*color_density + palette_offset;
+  frag_color = palette == 0 ? texture(pal0, t) : texture(pal1, t);
+}
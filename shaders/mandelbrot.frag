@@ -1,14 +1,12 @@
 #version 400 core
 
-out vec4 frag_color;
+out vec2 result;  // Smooth iteration count and |z| at escape.
 
 uniform int window_width;
 uniform int window_height;
 uniform dvec2 fractal_center;
 uniform double fractal_width;
 uniform double fractal_height;
-uniform sampler1D pal0;
-uniform sampler1D pal1;
 uniform int max_iter;
 
 
@@ -17,23 +15,48 @@ dvec2 square(dvec2 z) {
 }
 
 
+// Main cardioid or period-2 bulb; these points never escape.
+bool in_main_components(dvec2 c) {
+  double x = c.x - 0.25;
+  double y2 = c.y*c.y;
+  double q = x*x + y2;
+  double bx = c.x + 1.0;
+  return q*(q + x) <= 0.25*y2 || bx*bx + y2 <= 0.0625;
+}
+
+
 void main() {
   double w = window_width;
   double h = window_height;
-  double r = window_height/window_width;
   double cx = fractal_center.x + (gl_FragCoord.x / w - 0.5)*fractal_width;
   double cy = fractal_center.y + (gl_FragCoord.y / h - 0.5)*fractal_height;
   dvec2 c = dvec2(cx, cy);
 
+  if (in_main_components(c)) {
+    result = vec2(max_iter, 0.0);
+    return;
+  }
+
   dvec2 z = dvec2(0.0, 0.0);
+  dvec2 saved = z;
+  int next_save = 1;
 
   int iter = 0;
 
   while (iter < max_iter && length(z) < 2) {
     z = square(z) + c;
     iter++;
+    // Brent cycle detection: an exact repeat never escapes.
+    if (z == saved) {
+      iter = max_iter;
+      break;
+    }
+    if (iter == next_save) {
+      saved = z;
+      next_save *= 2;
+    }
   }
 
-  frag_color = texture1D(pal0, iter/float(max_iter));
-  //frag_color = length(z) < 2 ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(1.0, 1.0, 1.0, 1.0);
+  float r = float(length(z));
+  result = vec2(r >= 2.0 ? iter + 1 - log2(log(r)) : iter, r);
 }
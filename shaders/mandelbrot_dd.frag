@@ -0,0 +1,110 @@
+#version 400 core
+
+out vec2 result;  // Smooth iteration count and |z| at escape.
+
+uniform int window_width;
+uniform int window_height;
+uniform dvec2 fractal_center;
+uniform dvec2 fractal_center_lo;
+uniform double fractal_width;
+uniform double fractal_height;
+uniform int max_iter;
+
+
+// Double-double numbers: a dvec2 holds the unevaluated sum x + y, about 106
+// bits. `precise` stops the compiler from fusing or reordering the
+// error-free transformations they are built from.
+
+dvec2 two_sum(double a, double b) {
+  precise double s = a + b;
+  precise double bb = s - a;
+  precise double e = (a - (s - bb)) + (b - bb);
+  return dvec2(s, e);
+}
+
+
+dvec2 quick_two_sum(double a, double b) {
+  precise double s = a + b;
+  precise double e = b - (s - a);
+  return dvec2(s, e);
+}
+
+
+dvec2 two_prod(double a, double b) {
+  precise double p = a*b;
+  precise double e = fma(a, b, -p);
+  return dvec2(p, e);
+}
+
+
+dvec2 dd_add(dvec2 a, dvec2 b) {
+  dvec2 s = two_sum(a.x, b.x);
+  precise double e = (s.y + a.y) + b.y;
+  return quick_two_sum(s.x, e);
+}
+
+
+dvec2 dd_add(dvec2 a, double b) {
+  dvec2 s = two_sum(a.x, b);
+  precise double e = s.y + a.y;
+  return quick_two_sum(s.x, e);
+}
+
+
+dvec2 dd_mul(dvec2 a, dvec2 b) {
+  dvec2 p = two_prod(a.x, b.x);
+  precise double e = p.y + (a.x*b.y + a.y*b.x);
+  return quick_two_sum(p.x, e);
+}
+
+
+dvec2 dd_sqr(dvec2 a) {
+  dvec2 p = two_prod(a.x, a.x);
+  precise double e = p.y + 2.0*(a.x*a.y);
+  return quick_two_sum(p.x, e);
+}
+
+
+// No cardioid or bulb test: in double it cannot place their boundaries at
+// the zooms this shader is used for. Cycle detection still catches most
+// interior pixels.
+void main() {
+  double w = window_width;
+  double h = window_height;
+  dvec2 cx = dd_add(dvec2(fractal_center.x, fractal_center_lo.x),
+                    (gl_FragCoord.x / w - 0.5)*fractal_width);
+  dvec2 cy = dd_add(dvec2(fractal_center.y, fractal_center_lo.y),
+                    (gl_FragCoord.y / h - 0.5)*fractal_height);
+
+  dvec2 zx = dvec2(0.0);
+  dvec2 zy = dvec2(0.0);
+  dvec2 saved_x = zx;
+  dvec2 saved_y = zy;
+  int next_save = 1;
+
+  int iter = 0;
+
+  while (iter < max_iter) {
+    dvec2 x2 = dd_sqr(zx);
+    dvec2 y2 = dd_sqr(zy);
+    if (x2.x + y2.x >= 4.0) {
+      break;
+    }
+    dvec2 xy = dd_mul(zx, zy);
+    zx = dd_add(dd_add(x2, -y2), cx);
+    zy = dd_add(2.0*xy, cy);
+    iter++;
+    if (zx == saved_x && zy == saved_y) {
+      iter = max_iter;
+      break;
+    }
+    if (iter == next_save) {
+      saved_x = zx;
+      saved_y = zy;
+      next_save *= 2;
+    }
+  }
+
+  float r = float(length(dvec2(zx.x, zy.x)));
+  result = vec2(r >= 2.0 ? iter + 1 - log2(log(r)) : iter, r);
+}
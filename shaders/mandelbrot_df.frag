@@ -0,0 +1,124 @@
+#version 330 core
+#extension GL_ARB_gpu_shader5 : require
+
+out vec2 result;  // Smooth iteration count and |z| at escape.
+
+uniform int window_width;
+uniform int window_height;
+uniform vec2 float_center;     // The view's center as float_center +
+uniform vec2 float_center_lo;  // float_center_lo, about 48 bits.
+uniform vec2 float_size;       // Width and height.
+uniform int max_iter;
+
+
+// Double-float numbers: a vec2 holds the unevaluated sum x + y of two
+// floats, the same scheme as double-double in mandelbrot_dd.frag but
+// without doubles, so that it runs on GPUs whose fp64 rate is a small
+// fraction of fp32. The error-free transformations below only hold if the
+// compiler neither reassociates nor fuses them, which nothing but
+// `precise` from GL_ARB_gpu_shader5 forbids; without it `t - (t - a)` may
+// legally be folded to `a`. The product uses Dekker's split rather than
+// fma(), which the extension only makes a single operation, not an exact
+// one (llvmpipe drops its low bits).
+
+vec2 two_sum(float a, float b) {
+  precise float s = a + b;
+  precise float bb = s - a;
+  precise float e = (a - (s - bb)) + (b - bb);
+  return vec2(s, e);
+}
+
+
+vec2 quick_two_sum(float a, float b) {
+  precise float s = a + b;
+  precise float e = b - (s - a);
+  return vec2(s, e);
+}
+
+
+// Splits a into two halves of 12 bits whose products are exact.
+vec2 split(float a) {
+  precise float t = 4097.0*a;
+  precise float hi = t - (t - a);
+  precise float lo = a - hi;
+  return vec2(hi, lo);
+}
+
+
+vec2 two_prod(float a, float b) {
+  precise float p = a*b;
+  vec2 sa = split(a);
+  vec2 sb = split(b);
+  precise float e = ((sa.x*sb.x - p) + sa.x*sb.y + sa.y*sb.x) + sa.y*sb.y;
+  return vec2(p, e);
+}
+
+
+vec2 df_add(vec2 a, vec2 b) {
+  vec2 s = two_sum(a.x, b.x);
+  precise float e = (s.y + a.y) + b.y;
+  return quick_two_sum(s.x, e);
+}
+
+
+vec2 df_add(vec2 a, float b) {
+  vec2 s = two_sum(a.x, b);
+  precise float e = s.y + a.y;
+  return quick_two_sum(s.x, e);
+}
+
+
+vec2 df_mul(vec2 a, vec2 b) {
+  vec2 p = two_prod(a.x, b.x);
+  precise float e = p.y + (a.x*b.y + a.y*b.x);
+  return quick_two_sum(p.x, e);
+}
+
+
+vec2 df_sqr(vec2 a) {
+  vec2 p = two_prod(a.x, a.x);
+  precise float e = p.y + 2.0*(a.x*a.y);
+  return quick_two_sum(p.x, e);
+}
+
+
+// No cardioid or bulb test, as in mandelbrot_dd.frag: in float it cannot
+// place their boundaries at the zooms this shader is used for.
+void main() {
+  vec2 offset = (gl_FragCoord.xy / vec2(window_width, window_height) - 0.5)
+              * float_size;
+  vec2 cx = df_add(vec2(float_center.x, float_center_lo.x), offset.x);
+  vec2 cy = df_add(vec2(float_center.y, float_center_lo.y), offset.y);
+
+  vec2 zx = vec2(0.0);
+  vec2 zy = vec2(0.0);
+  vec2 saved_x = zx;
+  vec2 saved_y = zy;
+  int next_save = 1;
+
+  int iter = 0;
+
+  while (iter < max_iter) {
+    vec2 x2 = df_sqr(zx);
+    vec2 y2 = df_sqr(zy);
+    if (x2.x + y2.x >= 4.0) {
+      break;
+    }
+    vec2 xy = df_mul(zx, zy);
+    zx = df_add(df_add(x2, -y2), cx);
+    zy = df_add(2.0*xy, cy);
+    iter++;
+    if (zx == saved_x && zy == saved_y) {
+      iter = max_iter;
+      break;
+    }
+    if (iter == next_save) {
+      saved_x = zx;
+      saved_y = zy;
+      next_save *= 2;
+    }
+  }
+
+  float r = length(vec2(zx.x, zy.x));
+  result = vec2(r >= 2.0 ? iter + 1 - log2(log(r)) : iter, r);
+}
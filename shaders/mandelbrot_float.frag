@@ -0,0 +1,61 @@
+#version 330 core
+
+out vec2 result;  // Smooth iteration count and |z| at escape.
+
+uniform int window_width;
+uniform int window_height;
+uniform vec2 float_center;  // The view rounded to float.
+uniform vec2 float_size;    // Width and height.
+uniform int max_iter;
+
+// mandelbrot.frag in single precision, for views whose pixels are coarse
+// enough that float tells them apart. Needs no more than GL 3.3.
+
+
+vec2 square(vec2 z) {
+  return vec2(z.x*z.x - z.y*z.y, 2*z.x*z.y);
+}
+
+
+// Main cardioid or period-2 bulb; these points never escape.
+bool in_main_components(vec2 c) {
+  float x = c.x - 0.25;
+  float y2 = c.y*c.y;
+  float q = x*x + y2;
+  float bx = c.x + 1.0;
+  return q*(q + x) <= 0.25*y2 || bx*bx + y2 <= 0.0625;
+}
+
+
+void main() {
+  vec2 window = vec2(window_width, window_height);
+  vec2 c = float_center + (gl_FragCoord.xy / window - 0.5)*float_size;
+
+  if (in_main_components(c)) {
+    result = vec2(max_iter, 0.0);
+    return;
+  }
+
+  vec2 z = vec2(0.0, 0.0);
+  vec2 saved = z;
+  int next_save = 1;
+
+  int iter = 0;
+
+  while (iter < max_iter && length(z) < 2) {
+    z = square(z) + c;
+    iter++;
+    // Brent cycle detection: an exact repeat never escapes.
+    if (z == saved) {
+      iter = max_iter;
+      break;
+    }
+    if (iter == next_save) {
+      saved = z;
+      next_save *= 2;
+    }
+  }
+
+  float r = length(z);
+  result = vec2(r >= 2.0 ? iter + 1 - log2(log(r)) : iter, r);
+}
@@ -1,16 +1,23 @@
 #version 400 core
 
-out vec4 frag_color;
+out vec2 result;  // Index of the root reached (-1 for none) and steps taken.
 
 uniform int window_width;
 uniform int window_height;
 uniform dvec2 fractal_center;
 uniform double fractal_width;
 uniform double fractal_height;
-uniform sampler1D pal0;
-uniform sampler1D pal1;
 uniform int max_iter;
 
+// Written by Fractal::SetPolynomial(); must match Polynomial::kMaxDegree.
+const int max_degree = 16;
+
+layout(std140) uniform Polynomial {
+  dvec2 coefficients[max_degree + 1];  // coefficients[k] multiplies z^k.
+  dvec2 roots[max_degree];             // Found once on the CPU.
+  int degree;
+};
+
 
 dvec2 mult(dvec2 z, dvec2 w) {
   return dvec2(z.x*w.x - z.y*w.y, z.x*w.y + z.y*w.x);
@@ -32,52 +39,66 @@ dvec2 div(dvec2 z, dvec2 w) {
 }
 
 
-dvec2 f(dvec2 z) {
-  return mult(mult(z,z), z) - dvec2(1, 0);
-}
-
-
-dvec2 fprime(dvec2 z) {
-  return 3*mult(z,z);
+// f(z) and f'(z) in one Horner pass.
+void evaluate(dvec2 z, out dvec2 f, out dvec2 fprime) {
+  f = coefficients[degree];
+  fprime = dvec2(0.0);
+  for (int k = degree - 1; k >= 0; --k) {
+    fprime = mult(fprime, z) + f;
+    f = mult(f, z) + coefficients[k];
+  }
 }
 
 
-dvec2 newton_step(dvec2 z) {
-  return z - div(f(z), fprime(z));
-}
+// A pixel has converged once it is this close to a root or its Newton step
+// is this short.
+const double tolerance = 1e-4;
 
 
 void main() {
   double w = window_width;
   double h = window_height;
-  double r = window_height/window_width;
   double cx = fractal_center.x + (gl_FragCoord.x / w - 0.5)*fractal_width;
   double cy = fractal_center.y + (gl_FragCoord.y / h - 0.5)*fractal_height;
   dvec2 c = dvec2(cx, cy);
 
-  dvec2 z0 = dvec2(1, 0);
-  dvec2 z1 = dvec2(-0.5, sqrt(3)/2);
-  dvec2 z2 = dvec2(-0.5, -sqrt(3)/2);
-
   int iter = 0;
+  int root = -1;
+  double dist = 1.0;
 
   while (iter < max_iter) {
-    c = newton_step(c);
+    for (int i = 0; i < degree; ++i) {
+      double d = length(c - roots[i]);
+      if (d < tolerance) {
+        root = i;
+        dist = d;
+      }
+    }
+    if (root >= 0) {
+      break;
+    }
+    dvec2 f, fprime;
+    evaluate(c, f, fprime);
+    dvec2 step = div(f, fprime);
+    c -= step;
     iter++;
+    if (length(step) < tolerance) {
+      break;
+    }
   }
 
-
   double eps = 1e-2;
-  if (length(c-z0) < eps) {
-    frag_color = vec4(1.0, 0.0, 0.0, 1.0);
+  for (int i = 0; i < degree && root < 0; ++i) {
+    if (length(c - roots[i]) < eps) {
+      root = i;
+    }
   }
-  else if (length(c-z1) < eps) {
-    frag_color = vec4(0.0, 1.0, 0.0, 1.0);
-  }
-  else if (length(c-z2) < eps) {
-    frag_color = vec4(0.0, 0.0, 1.0, 1.0);
-  }
-  else {
-    frag_color = vec4(1.0, 1.0, 1.0, 1.0);
+
+  // Quadratic convergence squares the distance every step, so this puts the
+  // fraction of the last step where the distance crossed the tolerance.
+  float steps = iter;
+  if (dist > 0.0 && dist < tolerance) {
+    steps -= log2(log(float(dist))/log(float(tolerance)));
   }
+  result = vec2(root, steps);
 }
@@ -0,0 +1,158 @@
+#version 400 core
+
+out vec2 result;  // Index of the root reached (-1 for none) and steps taken.
+
+uniform int window_width;
+uniform int window_height;
+uniform dvec2 fractal_center;
+uniform dvec2 fractal_center_lo;
+uniform double fractal_width;
+uniform double fractal_height;
+uniform int max_iter;
+
+// Written by Fractal::SetPolynomial(); must match Polynomial::kMaxDegree.
+const int max_degree = 16;
+
+layout(std140) uniform Polynomial {
+  dvec2 coefficients[max_degree + 1];  // coefficients[k] multiplies z^k.
+  dvec2 roots[max_degree];             // Found once on the CPU.
+  int degree;
+};
+
+
+// Double-double numbers as in mandelbrot_dd.frag: a dvec2 holds the
+// unevaluated sum x + y. A complex number is a pair of them.
+
+dvec2 two_sum(double a, double b) {
+  precise double s = a + b;
+  precise double bb = s - a;
+  precise double e = (a - (s - bb)) + (b - bb);
+  return dvec2(s, e);
+}
+
+
+dvec2 quick_two_sum(double a, double b) {
+  precise double s = a + b;
+  precise double e = b - (s - a);
+  return dvec2(s, e);
+}
+
+
+dvec2 two_prod(double a, double b) {
+  precise double p = a*b;
+  precise double e = fma(a, b, -p);
+  return dvec2(p, e);
+}
+
+
+dvec2 dd_add(dvec2 a, dvec2 b) {
+  dvec2 s = two_sum(a.x, b.x);
+  precise double e = (s.y + a.y) + b.y;
+  return quick_two_sum(s.x, e);
+}
+
+
+dvec2 dd_add(dvec2 a, double b) {
+  dvec2 s = two_sum(a.x, b);
+  precise double e = s.y + a.y;
+  return quick_two_sum(s.x, e);
+}
+
+
+dvec2 dd_mul(dvec2 a, dvec2 b) {
+  dvec2 p = two_prod(a.x, b.x);
+  precise double e = p.y + (a.x*b.y + a.y*b.x);
+  return quick_two_sum(p.x, e);
+}
+
+
+dvec2 dd_mul(dvec2 a, double b) {
+  dvec2 p = two_prod(a.x, b);
+  precise double e = p.y + a.y*b;
+  return quick_two_sum(p.x, e);
+}
+
+
+dvec2 dd_div(dvec2 a, dvec2 b) {
+  precise double q1 = a.x/b.x;
+  dvec2 r = dd_add(a, -dd_mul(b, q1));
+  precise double q2 = r.x/b.x;
+  return quick_two_sum(q1, q2);
+}
+
+
+// f(z) and f'(z) in one Horner pass, z = (x, y).
+void evaluate(dvec2 x, dvec2 y, out dvec2 fx, out dvec2 fy, out dvec2 dx,
+              out dvec2 dy) {
+  fx = dvec2(coefficients[degree].x, 0.0);
+  fy = dvec2(coefficients[degree].y, 0.0);
+  dx = dvec2(0.0);
+  dy = dvec2(0.0);
+  for (int k = degree - 1; k >= 0; --k) {
+    dvec2 ndx = dd_add(dd_add(dd_mul(dx, x), -dd_mul(dy, y)), fx);
+    dy = dd_add(dd_add(dd_mul(dx, y), dd_mul(dy, x)), fy);
+    dx = ndx;
+    dvec2 nfx = dd_add(dd_add(dd_mul(fx, x), -dd_mul(fy, y)),
+                       coefficients[k].x);
+    fy = dd_add(dd_add(dd_mul(fx, y), dd_mul(fy, x)), coefficients[k].y);
+    fx = nfx;
+  }
+}
+
+
+// A pixel has converged once it is this close to a root or its Newton step
+// is this short.
+const double tolerance = 1e-4;
+
+
+void main() {
+  double w = window_width;
+  double h = window_height;
+  dvec2 x = dd_add(dvec2(fractal_center.x, fractal_center_lo.x),
+                   (gl_FragCoord.x / w - 0.5)*fractal_width);
+  dvec2 y = dd_add(dvec2(fractal_center.y, fractal_center_lo.y),
+                   (gl_FragCoord.y / h - 0.5)*fractal_height);
+
+  int iter = 0;
+  int root = -1;
+  double dist = 1.0;
+
+  while (iter < max_iter) {
+    for (int i = 0; i < degree; ++i) {
+      double d = length(dvec2(x.x, y.x) - roots[i]);
+      if (d < tolerance) {
+        root = i;
+        dist = d;
+      }
+    }
+    if (root >= 0) {
+      break;
+    }
+    dvec2 fx, fy, dx, dy;
+    evaluate(x, y, fx, fy, dx, dy);
+    dvec2 d = dd_add(dd_mul(dx, dx), dd_mul(dy, dy));
+    dvec2 sx = dd_div(dd_add(dd_mul(fx, dx), dd_mul(fy, dy)), d);
+    dvec2 sy = dd_div(dd_add(dd_mul(fy, dx), -dd_mul(fx, dy)), d);
+    x = dd_add(x, -sx);
+    y = dd_add(y, -sy);
+    iter++;
+    if (length(dvec2(sx.x, sy.x)) < tolerance) {
+      break;
+    }
+  }
+
+  double eps = 1e-2;
+  for (int i = 0; i < degree && root < 0; ++i) {
+    if (length(dvec2(x.x, y.x) - roots[i]) < eps) {
+      root = i;
+    }
+  }
+
+  // Quadratic convergence squares the distance every step, so this puts the
+  // fraction of the last step where the distance crossed the tolerance.
+  float steps = iter;
+  if (dist > 0.0 && dist < tolerance) {
+    steps -= log2(log(float(dist))/log(float(tolerance)));
+  }
+  result = vec2(root, steps);
+}
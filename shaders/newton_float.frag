@@ -0,0 +1,109 @@
+#version 400 core
+
+out vec2 result;  // Index of the root reached (-1 for none) and steps taken.
+
+uniform int window_width;
+uniform int window_height;
+uniform dvec2 fractal_center;
+uniform double fractal_width;
+uniform double fractal_height;
+uniform int max_iter;
+
+// newton.frag in single precision, for zoomed out views. The polynomial
+// stays in doubles, as the block is shared with newton.frag, and is rounded
+// as it is read.
+
+// Written by Fractal::SetPolynomial(); must match Polynomial::kMaxDegree.
+const int max_degree = 16;
+
+layout(std140) uniform Polynomial {
+  dvec2 coefficients[max_degree + 1];  // coefficients[k] multiplies z^k.
+  dvec2 roots[max_degree];             // Found once on the CPU.
+  int degree;
+};
+
+
+vec2 mult(vec2 z, vec2 w) {
+  return vec2(z.x*w.x - z.y*w.y, z.x*w.y + z.y*w.x);
+}
+
+
+vec2 conj(vec2 z) {
+  return vec2(z.x, -z.y);
+}
+
+
+float lensq(vec2 z) {
+  return z.x*z.x + z.y*z.y;
+}
+
+
+vec2 div(vec2 z, vec2 w) {
+  return mult(z, conj(w))/lensq(w);
+}
+
+
+// f(z) and f'(z) in one Horner pass.
+void evaluate(vec2 z, out vec2 f, out vec2 fprime) {
+  f = vec2(coefficients[degree]);
+  fprime = vec2(0.0);
+  for (int k = degree - 1; k >= 0; --k) {
+    fprime = mult(fprime, z) + f;
+    f = mult(f, z) + vec2(coefficients[k]);
+  }
+}
+
+
+// A pixel has converged once it is this close to a root or its Newton step
+// is this short.
+const float tolerance = 1e-4;
+
+
+void main() {
+  vec2 center = vec2(fractal_center);
+  float w = window_width;
+  float h = window_height;
+  float cx = center.x + (gl_FragCoord.x / w - 0.5)*float(fractal_width);
+  float cy = center.y + (gl_FragCoord.y / h - 0.5)*float(fractal_height);
+  vec2 c = vec2(cx, cy);
+
+  int iter = 0;
+  int root = -1;
+  float dist = 1.0;
+
+  while (iter < max_iter) {
+    for (int i = 0; i < degree; ++i) {
+      float d = length(c - vec2(roots[i]));
+      if (d < tolerance) {
+        root = i;
+        dist = d;
+      }
+    }
+    if (root >= 0) {
+      break;
+    }
+    vec2 f, fprime;
+    evaluate(c, f, fprime);
+    vec2 step = div(f, fprime);
+    c -= step;
+    iter++;
+    if (length(step) < tolerance) {
+      break;
+    }
+  }
+
+  float eps = 1e-2;
+  for (int i = 0; i < degree && root < 0; ++i) {
+    if (length(c - vec2(roots[i])) < eps) {
+      root = i;
+    }
+  }
+
+  // Quadratic convergence squares the distance every step, so this puts the
+  // fraction of the last step where the distance crossed the tolerance.
+  float steps = iter;
+  if (dist > 0.0 && dist < tolerance) {
+    steps -= log2(log(dist)/log(tolerance));
+  }
+  result = vec2(root, steps);
+}
@@ -0,0 +1,62 @@
+#version 400 core
+
+out vec2 result;  // Smooth iteration count and |z| at escape.
+
+uniform int window_width;
+uniform int window_height;
+uniform dvec2 fractal_center;  // Offset from the reference point.
+uniform double fractal_width;
+uniform double fractal_height;
+uniform int max_iter;
+uniform usamplerBuffer orbit;  // Z_n as pairs of doubles split into uints.
+uniform int orbit_length;
+
+
+dvec2 mult(dvec2 z, dvec2 w) {
+  return dvec2(z.x*w.x - z.y*w.y, z.x*w.y + z.y*w.x);
+}
+
+
+dvec2 orbit_at(int n) {
+  uvec4 t = texelFetch(orbit, n);
+  return dvec2(packDouble2x32(t.xy), packDouble2x32(t.zw));
+}
+
+
+void main() {
+  double w = window_width;
+  double h = window_height;
+  double dcx = fractal_center.x + (gl_FragCoord.x / w - 0.5)*fractal_width;
+  double dcy = fractal_center.y + (gl_FragCoord.y / h - 0.5)*fractal_height;
+  dvec2 dc = dvec2(dcx, dcy);
+
+  dvec2 d = dvec2(0.0, 0.0);
+
+  // A pixel whose offset grows larger than its value, or that outlives the
+  // reference, carries on from Z_0 = 0 with its full value as the offset.
+  // The first comes before the cancellation the CPU kernels flag as a
+  // glitch (Pauldelbrot), so no secondary references are needed, and the
+  // second lets early escaping references through.
+  int iter = 0;
+  int n = 0;
+  dvec2 z = dvec2(0.0, 0.0);
+
+  while (iter < max_iter) {
+    dvec2 Z = orbit_at(n);
+    z = Z + d;
+    if (dot(z, z) >= 4) {
+      break;
+    }
+    if (dot(z, z) < dot(d, d) || n == orbit_length - 1) {
+      d = z;
+      Z = dvec2(0.0, 0.0);
+      n = 0;
+    }
+    d = mult(2*Z + d, d) + dc;
+    n++;
+    iter++;
+  }
+
+  float r = float(length(z));
+  result = vec2(r >= 2.0 ? iter + 1 - log2(log(r)) : iter, r);
+}
@@ -0,0 +1,46 @@
+#include "bla.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+void BlaTable::Build(const ReferenceOrbit& orbit, double max_dc,
+                     double epsilon) {
+  levels_.clear();
+
+  // Steps n -> n+1 for n = 1 .. length-2; Z_0 = 0 has nothing to offer.
+  std::vector<BlaStep> level;
+  for (int n = 1; n + 1 < orbit.length(); ++n) {
+    const double ax = 2.0*orbit.re[n];
+    const double ay = 2.0*orbit.im[n];
+    const double r = epsilon*std::hypot(ax, ay);
+    level.push_back({ax, ay, 1.0, 0.0, r*r, 1});
+  }
+
+  while (level.size() > 1) {
+    std::vector<BlaStep> merged;
+    for (size_t i = 0; i + 1 < level.size(); i += 2) {
+      const BlaStep& x = level[i];
+      const BlaStep& y = level[i+1];
+      const double ax_abs = std::hypot(x.ax, x.ay);
+      const double bx_abs = std::hypot(x.bx, x.by);
+      const double ry = std::sqrt(y.r2);
+      const double r = std::min(
+          std::sqrt(x.r2),
+          std::max(0.0, (ry - bx_abs*max_dc)/ax_abs));
+      merged.push_back({
+        y.ax*x.ax - y.ay*x.ay,
+        y.ax*x.ay + y.ay*x.ax,
+        (y.ax*x.bx - y.ay*x.by) + y.bx,
+        (y.ax*x.by + y.ay*x.bx) + y.by,
+        r*r,
+        x.length + y.length,
+      });
+    }
+    levels_.push_back(std::move(level));
+    level = std::move(merged);
+  }
+  if (!level.empty()) {
+    levels_.push_back(std::move(level));
+  }
+}
@@ -0,0 +1,211 @@
+#include "cpu_renderer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "precision.hpp"
+
+
+namespace {
+
+// Rectangles with at most this many unknown pixels inside are computed
+// rather than split further.
+constexpr int kMinRefineArea = 16;
+
+// An inclusive rectangle of pixels whose border is known.
+struct Rect {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+
+// Pixels waiting to be computed by the points kernel.
+struct PixelBatch {
+  std::vector<int> x;
+  std::vector<int> y;
+  std::vector<int> result;
+
+  void Add(int px, int py) {
+    x.push_back(px);
+    y.push_back(py);
+  }
+};
+
+
+bool UniformBorder(const IterationBuffer& buffer, const Rect& r) {
+  const int value = buffer.at(r.x0, r.y0);
+  for (int x = r.x0; x <= r.x1; ++x) {
+    if (buffer.at(x, r.y0) != value || buffer.at(x, r.y1) != value) {
+      return false;
+    }
+  }
+  for (int y = r.y0 + 1; y < r.y1; ++y) {
+    if (buffer.at(r.x0, y) != value || buffer.at(r.x1, y) != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+
+CpuRenderer::CpuRenderer(int num_threads, Isa isa)
+    : own_scheduler_(std::make_unique<TileScheduler>(num_threads)),
+      scheduler_(own_scheduler_.get()),
+      isa_(IsaSupported(isa) ? isa : Isa::kScalar),
+      kernel_(GetMandelbrotRowKernel(isa_)),
+      points_kernel_(GetMandelbrotPointsKernel(isa_)),
+      dd_kernel_(GetMandelbrotDdRowKernel(isa_)),
+      dd_points_kernel_(GetMandelbrotDdPointsKernel(isa_)) {
+}
+
+
+CpuRenderer::CpuRenderer(TileScheduler& scheduler, Isa isa)
+    : scheduler_(&scheduler),
+      isa_(IsaSupported(isa) ? isa : Isa::kScalar),
+      kernel_(GetMandelbrotRowKernel(isa_)),
+      points_kernel_(GetMandelbrotPointsKernel(isa_)),
+      dd_kernel_(GetMandelbrotDdRowKernel(isa_)),
+      dd_points_kernel_(GetMandelbrotDdPointsKernel(isa_)) {
+}
+
+
+void CpuRenderer::set_interior_checks(bool enabled) {
+  interior_checks_ = enabled;
+  kernel_ = GetMandelbrotRowKernel(isa_, enabled);
+  points_kernel_ = GetMandelbrotPointsKernel(isa_, enabled);
+  dd_kernel_ = GetMandelbrotDdRowKernel(isa_, enabled);
+  dd_points_kernel_ = GetMandelbrotDdPointsKernel(isa_, enabled);
+}
+
+
+void CpuRenderer::Render(const View& view, IterationBuffer& buffer) {
+  if (subdivision_) {
+    RenderSubdivided(view, buffer);
+    return;
+  }
+  buffer.Resize(view.pixel_width, view.pixel_height);
+
+  const MandelbrotRowKernel kernel =
+      ChoosePrecision(view) >= Precision::kDoubleDouble ? dd_kernel_ : kernel_;
+  scheduler_->Run(view.pixel_width, view.pixel_height, [&](const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      kernel(view, y, tile.x0, tile.x1, &buffer.at(tile.x0, y));
+    }
+  });
+}
+
+
+void CpuRenderer::RenderSubdivided(const View& view, IterationBuffer& buffer) {
+  buffer.Resize(view.pixel_width, view.pixel_height);
+
+  std::atomic<long> computed{0};
+  scheduler_->Run(view.pixel_width, view.pixel_height, [&](const Tile& tile) {
+    computed += RefineTile(view, buffer, tile);
+  });
+
+  stats_ = {};
+  stats_.computed_pixels = computed;
+  stats_.skipped_pixels =
+      static_cast<long>(view.pixel_width)*view.pixel_height - computed;
+
+  if (verify_) {
+    IterationBuffer brute;
+    subdivision_ = false;
+    Render(view, brute);
+    subdivision_ = true;
+    for (size_t i = 0; i < brute.data.size(); ++i) {
+      stats_.mismatched_pixels += brute.data[i] != buffer.data[i];
+    }
+  }
+}
+
+
+// Returns the number of pixels actually computed.
+long CpuRenderer::RefineTile(const View& view, IterationBuffer& buffer,
+                             const Tile& tile) const {
+  thread_local PixelBatch batch;
+  thread_local std::vector<Rect> rects;
+  thread_local std::vector<Rect> next;
+
+  const MandelbrotPointsKernel points_kernel =
+      ChoosePrecision(view) >= Precision::kDoubleDouble
+          ? dd_points_kernel_ : points_kernel_;
+  long computed = 0;
+  auto compute_batch = [&] {
+    const int n = static_cast<int>(batch.x.size());
+    batch.result.resize(n);
+    points_kernel(view, n, batch.x.data(), batch.y.data(),
+                  batch.result.data());
+    for (int i = 0; i < n; ++i) {
+      buffer.at(batch.x[i], batch.y[i]) = batch.result[i];
+    }
+    batch.x.clear();
+    batch.y.clear();
+    computed += n;
+  };
+
+  const Rect whole{tile.x0, tile.y0, tile.x1 - 1, tile.y1 - 1};
+  for (int x = whole.x0; x <= whole.x1; ++x) {
+    batch.Add(x, whole.y0);
+    if (whole.y1 > whole.y0) {
+      batch.Add(x, whole.y1);
+    }
+  }
+  for (int y = whole.y0 + 1; y < whole.y1; ++y) {
+    batch.Add(whole.x0, y);
+    if (whole.x1 > whole.x0) {
+      batch.Add(whole.x1, y);
+    }
+  }
+
+  rects.assign(1, whole);
+  while (!rects.empty()) {
+    compute_batch();
+    next.clear();
+    for (const Rect& r : rects) {
+      if (r.x1 - r.x0 < 2 || r.y1 - r.y0 < 2) {
+        continue;
+      }
+      if (UniformBorder(buffer, r)) {
+        const int value = buffer.at(r.x0, r.y0);
+        for (int y = r.y0 + 1; y < r.y1; ++y) {
+          std::fill(&buffer.at(r.x0 + 1, y), &buffer.at(r.x1, y), value);
+        }
+        continue;
+      }
+      if ((r.x1 - r.x0 - 1)*(r.y1 - r.y0 - 1) <= kMinRefineArea) {
+        for (int y = r.y0 + 1; y < r.y1; ++y) {
+          for (int x = r.x0 + 1; x < r.x1; ++x) {
+            batch.Add(x, y);
+          }
+        }
+        continue;
+      }
+
+      const int xm = (r.x0 + r.x1)/2;
+      const int ym = (r.y0 + r.y1)/2;
+      for (int x = r.x0 + 1; x < r.x1; ++x) {
+        batch.Add(x, ym);
+      }
+      for (int y = r.y0 + 1; y < r.y1; ++y) {
+        if (y != ym) {
+          batch.Add(xm, y);
+        }
+      }
+      next.push_back({r.x0, r.y0, xm, ym});
+      next.push_back({xm, r.y0, r.x1, ym});
+      next.push_back({r.x0, ym, xm, r.y1});
+      next.push_back({xm, ym, r.x1, r.y1});
+    }
+    std::swap(rects, next);
+  }
+  // Interiors of the last small rectangles.
+  compute_batch();
+  return computed;
+}
@@ -0,0 +1,1020 @@
+#include "kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FRACTAL_X86 1
+#include <immintrin.h>
+#endif
+
+
+// Double-double arithmetic after Dekker and Knuth, as in the QD library but
+// with its cheaper "sloppy" addition, whose error is relative to the larger
+// operand rather than the result. That is all the kernels need, as |z| stays
+// below 2. Products are split by hand rather than computed with an FMA, so
+// every machine rounds them the same, and this file is built with
+// -ffp-contract=off so that nothing else gets fused either.
+
+namespace {
+
+// Splits a double into two halves of 26 bits each.
+constexpr double kSplit = 134217729.0;  // 2^27 + 1
+
+// The unevaluated sum hi + lo, with |lo| at most half an ulp of hi.
+struct Dd {
+  double hi;
+  double lo;
+};
+
+
+Dd TwoSum(double a, double b) {
+  const double s = a + b;
+  const double bb = s - a;
+  return {s, (a - (s - bb)) + (b - bb)};
+}
+
+
+Dd TwoDiff(double a, double b) {
+  const double s = a - b;
+  const double bb = s - a;
+  return {s, (a - (s - bb)) - (b + bb)};
+}
+
+
+// Only exact for |a| >= |b|.
+Dd QuickTwoSum(double a, double b) {
+  const double s = a + b;
+  return {s, b - (s - a)};
+}
+
+
+Dd TwoProd(double a, double b) {
+  const double p = a*b;
+  const double ta = kSplit*a;
+  const double ah = ta - (ta - a);
+  const double al = a - ah;
+  const double tb = kSplit*b;
+  const double bh = tb - (tb - b);
+  const double bl = b - bh;
+  return {p, (((ah*bh - p) + ah*bl) + al*bh) + al*bl};
+}
+
+
+Dd Add(Dd a, Dd b) {
+  const Dd s = TwoSum(a.hi, b.hi);
+  return QuickTwoSum(s.hi, (s.lo + a.lo) + b.lo);
+}
+
+
+Dd Add(Dd a, double b) {
+  const Dd s = TwoSum(a.hi, b);
+  return QuickTwoSum(s.hi, s.lo + a.lo);
+}
+
+
+Dd Sub(Dd a, Dd b) {
+  const Dd s = TwoDiff(a.hi, b.hi);
+  return QuickTwoSum(s.hi, (s.lo + a.lo) - b.lo);
+}
+
+
+Dd Mul(Dd a, Dd b) {
+  const Dd p = TwoProd(a.hi, b.hi);
+  return QuickTwoSum(p.hi, p.lo + (a.hi*b.lo + a.lo*b.hi));
+}
+
+
+Dd Mul(Dd a, double b) {
+  const Dd p = TwoProd(a.hi, b);
+  return QuickTwoSum(p.hi, p.lo + a.lo*b);
+}
+
+
+Dd Sqr(Dd a) {
+  const Dd p = TwoProd(a.hi, a.hi);
+  return QuickTwoSum(p.hi, p.lo + 2.0*(a.hi*a.lo));
+}
+
+
+Dd Div(Dd a, Dd b) {
+  const double q1 = a.hi/b.hi;
+  const Dd r = Sub(a, Mul(b, q1));
+  return QuickTwoSum(q1, r.hi/b.hi);
+}
+
+
+// Pixel centers: the offsets are computed exactly like PixelX() and PixelY()
+// in kernels.cpp and then added to the full center.
+Dd PixelX(const View& view, double width, int x) {
+  return Add(Dd{view.center.x, view.center_lo.x},
+             ((x + 0.5)/view.pixel_width - 0.5)*width);
+}
+
+
+Dd PixelY(const View& view, int y) {
+  return Add(Dd{view.center.y, view.center_lo.y},
+             ((y + 0.5)/view.pixel_height - 0.5)*view.height);
+}
+
+
+template <bool kInteriorChecks>
+int MandelbrotPoint(Dd cx, Dd cy, int max_iter) {
+  Dd x{0.0, 0.0};
+  Dd y{0.0, 0.0};
+  Dd saved_x{0.0, 0.0};
+  Dd saved_y{0.0, 0.0};
+  int next_save = 1;
+  int iter = 0;
+  while (iter < max_iter) {
+    const Dd x2 = Sqr(x);
+    const Dd y2 = Sqr(y);
+    if (!(x2.hi + y2.hi < 4.0)) {
+      break;
+    }
+    const Dd xy = Mul(x, y);
+    x = Add(Sub(x2, y2), cx);
+    y = Add(Dd{2.0*xy.hi, 2.0*xy.lo}, cy);
+    ++iter;
+    if (kInteriorChecks) {
+      if (x.hi == saved_x.hi && x.lo == saved_x.lo &&
+          y.hi == saved_y.hi && y.lo == saved_y.lo) {
+        return max_iter;
+      }
+      if (iter == next_save) {
+        saved_x = x;
+        saved_y = y;
+        next_save *= 2;
+      }
+    }
+  }
+  return iter;
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotDdRowScalarImpl(const View& view, int y, int x0, int x1,
+                               int* out) {
+  const double width = view.width();
+  const Dd cy = PixelY(view, y);
+  for (int x = x0; x < x1; ++x) {
+    out[x-x0] = MandelbrotPoint<kInteriorChecks>(PixelX(view, width, x), cy,
+                                                 view.max_iter);
+  }
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotDdPointsScalarImpl(const View& view, int n, const int* x,
+                                  const int* y, int* out) {
+  const double width = view.width();
+  for (int i = 0; i < n; ++i) {
+    out[i] = MandelbrotPoint<kInteriorChecks>(
+        PixelX(view, width, x[i]), PixelY(view, y[i]), view.max_iter);
+  }
+}
+
+
+int NewtonPoint(const Polynomial& polynomial, Dd x, Dd y, int max_iter,
+                int* steps) {
+  const auto& c = polynomial.coefficients();
+  const auto& roots = polynomial.roots();
+  const int n = polynomial.degree();
+  const double tolerance2 = kNewtonTolerance*kNewtonTolerance;
+  int iter = 0;
+  while (iter < max_iter) {
+    for (int i = 0; i < n; ++i) {
+      const double ex = x.hi - roots[i].real();
+      const double ey = y.hi - roots[i].imag();
+      if (ex*ex + ey*ey < tolerance2) {
+        *steps = iter;
+        return i;
+      }
+    }
+
+    Dd fx{c[n].real(), 0.0};
+    Dd fy{c[n].imag(), 0.0};
+    Dd dx{0.0, 0.0};
+    Dd dy{0.0, 0.0};
+    for (int k = n - 1; k >= 0; --k) {
+      const Dd ndx = Add(Sub(Mul(dx, x), Mul(dy, y)), fx);
+      dy = Add(Add(Mul(dx, y), Mul(dy, x)), fy);
+      dx = ndx;
+      const Dd nfx = Add(Sub(Mul(fx, x), Mul(fy, y)), c[k].real());
+      fy = Add(Add(Mul(fx, y), Mul(fy, x)), c[k].imag());
+      fx = nfx;
+    }
+    const Dd d = Add(Sqr(dx), Sqr(dy));
+    const Dd sx = Div(Add(Mul(fx, dx), Mul(fy, dy)), d);
+    const Dd sy = Div(Sub(Mul(fy, dx), Mul(fx, dy)), d);
+    x = Sub(x, sx);
+    y = Sub(y, sy);
+    ++iter;
+    if (sx.hi*sx.hi + sy.hi*sy.hi < tolerance2) {
+      break;
+    }
+  }
+
+  *steps = iter;
+  const double radius2 = kNewtonRootRadius*kNewtonRootRadius;
+  for (int i = 0; i < n; ++i) {
+    const double ex = x.hi - roots[i].real();
+    const double ey = y.hi - roots[i].imag();
+    if (ex*ex + ey*ey < radius2) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+
+void MandelbrotDdRowScalar(const View& view, int y, int x0, int x1,
+                           int* out) {
+  MandelbrotDdRowScalarImpl<true>(view, y, x0, x1, out);
+}
+
+
+void NewtonDdRowScalar(const Polynomial& polynomial, const View& view, int y,
+                       int x0, int x1, int* roots, int* steps) {
+  const double width = view.width();
+  const Dd zy = PixelY(view, y);
+  for (int x = x0; x < x1; ++x) {
+    roots[x-x0] = NewtonPoint(polynomial, PixelX(view, width, x), zy,
+                              view.max_iter, &steps[x-x0]);
+  }
+}
+
+
+#ifdef FRACTAL_X86
+
+// The same operations lane by lane, with the conventions of the double
+// kernels: lanes that are done stop counting but keep iterating until the
+// whole vector is.
+
+namespace {
+
+struct Dd4 {
+  __m256d hi;
+  __m256d lo;
+};
+
+
+__attribute__((target("avx2")))
+inline Dd4 TwoSum(__m256d a, __m256d b) {
+  const __m256d s = _mm256_add_pd(a, b);
+  const __m256d bb = _mm256_sub_pd(s, a);
+  return {s, _mm256_add_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, bb)),
+                           _mm256_sub_pd(b, bb))};
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 TwoDiff(__m256d a, __m256d b) {
+  const __m256d s = _mm256_sub_pd(a, b);
+  const __m256d bb = _mm256_sub_pd(s, a);
+  return {s, _mm256_sub_pd(_mm256_sub_pd(a, _mm256_sub_pd(s, bb)),
+                           _mm256_add_pd(b, bb))};
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 QuickTwoSum(__m256d a, __m256d b) {
+  const __m256d s = _mm256_add_pd(a, b);
+  return {s, _mm256_sub_pd(b, _mm256_sub_pd(s, a))};
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 TwoProd(__m256d a, __m256d b) {
+  const __m256d split = _mm256_set1_pd(kSplit);
+  const __m256d p = _mm256_mul_pd(a, b);
+  const __m256d ta = _mm256_mul_pd(split, a);
+  const __m256d ah = _mm256_sub_pd(ta, _mm256_sub_pd(ta, a));
+  const __m256d al = _mm256_sub_pd(a, ah);
+  const __m256d tb = _mm256_mul_pd(split, b);
+  const __m256d bh = _mm256_sub_pd(tb, _mm256_sub_pd(tb, b));
+  const __m256d bl = _mm256_sub_pd(b, bh);
+  __m256d e = _mm256_sub_pd(_mm256_mul_pd(ah, bh), p);
+  e = _mm256_add_pd(e, _mm256_mul_pd(ah, bl));
+  e = _mm256_add_pd(e, _mm256_mul_pd(al, bh));
+  return {p, _mm256_add_pd(e, _mm256_mul_pd(al, bl))};
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Add(Dd4 a, Dd4 b) {
+  const Dd4 s = TwoSum(a.hi, b.hi);
+  return QuickTwoSum(s.hi, _mm256_add_pd(_mm256_add_pd(s.lo, a.lo), b.lo));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Add(Dd4 a, __m256d b) {
+  const Dd4 s = TwoSum(a.hi, b);
+  return QuickTwoSum(s.hi, _mm256_add_pd(s.lo, a.lo));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Sub(Dd4 a, Dd4 b) {
+  const Dd4 s = TwoDiff(a.hi, b.hi);
+  return QuickTwoSum(s.hi, _mm256_sub_pd(_mm256_add_pd(s.lo, a.lo), b.lo));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Mul(Dd4 a, Dd4 b) {
+  const Dd4 p = TwoProd(a.hi, b.hi);
+  return QuickTwoSum(p.hi, _mm256_add_pd(p.lo, _mm256_add_pd(
+      _mm256_mul_pd(a.hi, b.lo), _mm256_mul_pd(a.lo, b.hi))));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Mul(Dd4 a, __m256d b) {
+  const Dd4 p = TwoProd(a.hi, b);
+  return QuickTwoSum(p.hi, _mm256_add_pd(p.lo, _mm256_mul_pd(a.lo, b)));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Sqr(Dd4 a) {
+  const Dd4 p = TwoProd(a.hi, a.hi);
+  return QuickTwoSum(p.hi, _mm256_add_pd(p.lo, _mm256_mul_pd(
+      _mm256_set1_pd(2.0), _mm256_mul_pd(a.hi, a.lo))));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Div(Dd4 a, Dd4 b) {
+  const __m256d q1 = _mm256_div_pd(a.hi, b.hi);
+  const Dd4 r = Sub(a, Mul(b, q1));
+  return QuickTwoSum(q1, _mm256_div_pd(r.hi, b.hi));
+}
+
+
+__attribute__((target("avx2")))
+inline Dd4 Blend(Dd4 a, Dd4 b, __m256d mask) {
+  return {_mm256_blendv_pd(a.hi, b.hi, mask),
+          _mm256_blendv_pd(a.lo, b.lo, mask)};
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx2")))
+__m256d MandelbrotDdAvx2(Dd4 cx, Dd4 cy, int max_iter) {
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d four = _mm256_set1_pd(4.0);
+
+  Dd4 zx{zero, zero};
+  Dd4 zy{zero, zero};
+  __m256d count = zero;
+  __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  __m256d inside = zero;
+  Dd4 saved_x{zero, zero};
+  Dd4 saved_y{zero, zero};
+  int next_save = 1;
+
+  for (int i = 0; i < max_iter; ++i) {
+    const Dd4 x2 = Sqr(zx);
+    const Dd4 y2 = Sqr(zy);
+    active = _mm256_and_pd(active, _mm256_cmp_pd(
+        _mm256_add_pd(x2.hi, y2.hi), four, _CMP_LT_OQ));
+    if (_mm256_movemask_pd(active) == 0) {
+      break;
+    }
+    count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+    const Dd4 xy = Mul(zx, zy);
+    zx = Add(Sub(x2, y2), cx);
+    zy = Add(Dd4{_mm256_mul_pd(two, xy.hi), _mm256_mul_pd(two, xy.lo)}, cy);
+    if (kInteriorChecks) {
+      const __m256d same_x = _mm256_and_pd(
+          _mm256_cmp_pd(zx.hi, saved_x.hi, _CMP_EQ_OQ),
+          _mm256_cmp_pd(zx.lo, saved_x.lo, _CMP_EQ_OQ));
+      const __m256d same_y = _mm256_and_pd(
+          _mm256_cmp_pd(zy.hi, saved_y.hi, _CMP_EQ_OQ),
+          _mm256_cmp_pd(zy.lo, saved_y.lo, _CMP_EQ_OQ));
+      const __m256d repeat =
+          _mm256_and_pd(active, _mm256_and_pd(same_x, same_y));
+      inside = _mm256_or_pd(inside, repeat);
+      active = _mm256_andnot_pd(repeat, active);
+      if (i + 1 == next_save) {
+        saved_x = zx;
+        saved_y = zy;
+        next_save *= 2;
+      }
+    }
+  }
+
+  if (kInteriorChecks) {
+    count = _mm256_blendv_pd(count, _mm256_set1_pd(max_iter), inside);
+  }
+  return count;
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx2")))
+void MandelbrotDdRowAvx2Impl(const View& view, int y, int x0, int x1,
+                             int* out) {
+  const Dd4 center_x{_mm256_set1_pd(view.center.x),
+                     _mm256_set1_pd(view.center_lo.x)};
+  const __m256d w = _mm256_set1_pd(view.width());
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const Dd cy = PixelY(view, y);
+  const Dd4 cy4{_mm256_set1_pd(cy.hi), _mm256_set1_pd(cy.lo)};
+
+  int x = x0;
+  for (; x + 4 <= x1; x += 4) {
+    __m256d px = _mm256_set_pd(x+3, x+2, x+1, x);
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    const Dd4 cx = Add(center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (x-x0)),
+                     _mm256_cvtpd_epi32(MandelbrotDdAvx2<kInteriorChecks>(
+                         cx, cy4, view.max_iter)));
+  }
+
+  if (x < x1) {
+    MandelbrotDdRowScalarImpl<kInteriorChecks>(view, y, x, x1, out + (x-x0));
+  }
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx2")))
+void MandelbrotDdPointsAvx2Impl(const View& view, int n, const int* x,
+                                const int* y, int* out) {
+  const Dd4 center_x{_mm256_set1_pd(view.center.x),
+                     _mm256_set1_pd(view.center_lo.x)};
+  const Dd4 center_y{_mm256_set1_pd(view.center.y),
+                     _mm256_set1_pd(view.center_lo.y)};
+  const __m256d w = _mm256_set1_pd(view.width());
+  const __m256d h = _mm256_set1_pd(view.height);
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d pixel_height = _mm256_set1_pd(view.pixel_height);
+  const __m256d half = _mm256_set1_pd(0.5);
+
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d px = _mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    __m256d py = _mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    py = _mm256_div_pd(_mm256_add_pd(py, half), pixel_height);
+    const Dd4 cx = Add(center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+    const Dd4 cy = Add(center_y, _mm256_mul_pd(_mm256_sub_pd(py, half), h));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm256_cvtpd_epi32(MandelbrotDdAvx2<kInteriorChecks>(
+                         cx, cy, view.max_iter)));
+  }
+
+  if (i < n) {
+    MandelbrotDdPointsScalarImpl<kInteriorChecks>(view, n - i, x + i, y + i,
+                                                  out + i);
+  }
+}
+
+
+struct Dd8 {
+  __m512d hi;
+  __m512d lo;
+};
+
+
+__attribute__((target("avx512f")))
+inline Dd8 TwoSum(__m512d a, __m512d b) {
+  const __m512d s = _mm512_add_pd(a, b);
+  const __m512d bb = _mm512_sub_pd(s, a);
+  return {s, _mm512_add_pd(_mm512_sub_pd(a, _mm512_sub_pd(s, bb)),
+                           _mm512_sub_pd(b, bb))};
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 TwoDiff(__m512d a, __m512d b) {
+  const __m512d s = _mm512_sub_pd(a, b);
+  const __m512d bb = _mm512_sub_pd(s, a);
+  return {s, _mm512_sub_pd(_mm512_sub_pd(a, _mm512_sub_pd(s, bb)),
+                           _mm512_add_pd(b, bb))};
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 QuickTwoSum(__m512d a, __m512d b) {
+  const __m512d s = _mm512_add_pd(a, b);
+  return {s, _mm512_sub_pd(b, _mm512_sub_pd(s, a))};
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 TwoProd(__m512d a, __m512d b) {
+  const __m512d split = _mm512_set1_pd(kSplit);
+  const __m512d p = _mm512_mul_pd(a, b);
+  const __m512d ta = _mm512_mul_pd(split, a);
+  const __m512d ah = _mm512_sub_pd(ta, _mm512_sub_pd(ta, a));
+  const __m512d al = _mm512_sub_pd(a, ah);
+  const __m512d tb = _mm512_mul_pd(split, b);
+  const __m512d bh = _mm512_sub_pd(tb, _mm512_sub_pd(tb, b));
+  const __m512d bl = _mm512_sub_pd(b, bh);
+  __m512d e = _mm512_sub_pd(_mm512_mul_pd(ah, bh), p);
+  e = _mm512_add_pd(e, _mm512_mul_pd(ah, bl));
+  e = _mm512_add_pd(e, _mm512_mul_pd(al, bh));
+  return {p, _mm512_add_pd(e, _mm512_mul_pd(al, bl))};
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Add(Dd8 a, Dd8 b) {
+  const Dd8 s = TwoSum(a.hi, b.hi);
+  return QuickTwoSum(s.hi, _mm512_add_pd(_mm512_add_pd(s.lo, a.lo), b.lo));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Add(Dd8 a, __m512d b) {
+  const Dd8 s = TwoSum(a.hi, b);
+  return QuickTwoSum(s.hi, _mm512_add_pd(s.lo, a.lo));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Sub(Dd8 a, Dd8 b) {
+  const Dd8 s = TwoDiff(a.hi, b.hi);
+  return QuickTwoSum(s.hi, _mm512_sub_pd(_mm512_add_pd(s.lo, a.lo), b.lo));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Mul(Dd8 a, Dd8 b) {
+  const Dd8 p = TwoProd(a.hi, b.hi);
+  return QuickTwoSum(p.hi, _mm512_add_pd(p.lo, _mm512_add_pd(
+      _mm512_mul_pd(a.hi, b.lo), _mm512_mul_pd(a.lo, b.hi))));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Mul(Dd8 a, __m512d b) {
+  const Dd8 p = TwoProd(a.hi, b);
+  return QuickTwoSum(p.hi, _mm512_add_pd(p.lo, _mm512_mul_pd(a.lo, b)));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Sqr(Dd8 a) {
+  const Dd8 p = TwoProd(a.hi, a.hi);
+  return QuickTwoSum(p.hi, _mm512_add_pd(p.lo, _mm512_mul_pd(
+      _mm512_set1_pd(2.0), _mm512_mul_pd(a.hi, a.lo))));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Div(Dd8 a, Dd8 b) {
+  const __m512d q1 = _mm512_div_pd(a.hi, b.hi);
+  const Dd8 r = Sub(a, Mul(b, q1));
+  return QuickTwoSum(q1, _mm512_div_pd(r.hi, b.hi));
+}
+
+
+__attribute__((target("avx512f")))
+inline Dd8 Blend(Dd8 a, Dd8 b, __mmask8 mask) {
+  return {_mm512_mask_mov_pd(a.hi, mask, b.hi),
+          _mm512_mask_mov_pd(a.lo, mask, b.lo)};
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx512f")))
+__m512d MandelbrotDdAvx512(Dd8 cx, Dd8 cy, int max_iter) {
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d four = _mm512_set1_pd(4.0);
+
+  Dd8 zx{zero, zero};
+  Dd8 zy{zero, zero};
+  __m512d count = zero;
+  __mmask8 active = 0xff;
+  __mmask8 inside = 0;
+  Dd8 saved_x{zero, zero};
+  Dd8 saved_y{zero, zero};
+  int next_save = 1;
+
+  for (int i = 0; i < max_iter; ++i) {
+    const Dd8 x2 = Sqr(zx);
+    const Dd8 y2 = Sqr(zy);
+    active = _mm512_mask_cmp_pd_mask(
+        active, _mm512_add_pd(x2.hi, y2.hi), four, _CMP_LT_OQ);
+    if (active == 0) {
+      break;
+    }
+    count = _mm512_mask_add_pd(count, active, count, one);
+    const Dd8 xy = Mul(zx, zy);
+    zx = Add(Sub(x2, y2), cx);
+    zy = Add(Dd8{_mm512_mul_pd(two, xy.hi), _mm512_mul_pd(two, xy.lo)}, cy);
+    if (kInteriorChecks) {
+      const __mmask8 repeat =
+          _mm512_mask_cmp_pd_mask(active, zx.hi, saved_x.hi, _CMP_EQ_OQ) &
+          _mm512_mask_cmp_pd_mask(active, zx.lo, saved_x.lo, _CMP_EQ_OQ) &
+          _mm512_mask_cmp_pd_mask(active, zy.hi, saved_y.hi, _CMP_EQ_OQ) &
+          _mm512_mask_cmp_pd_mask(active, zy.lo, saved_y.lo, _CMP_EQ_OQ);
+      inside |= repeat;
+      active &= ~repeat;
+      if (i + 1 == next_save) {
+        saved_x = zx;
+        saved_y = zy;
+        next_save *= 2;
+      }
+    }
+  }
+
+  if (kInteriorChecks) {
+    count = _mm512_mask_mov_pd(count, inside, _mm512_set1_pd(max_iter));
+  }
+  return count;
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx512f")))
+void MandelbrotDdRowAvx512Impl(const View& view, int y, int x0, int x1,
+                               int* out) {
+  const Dd8 center_x{_mm512_set1_pd(view.center.x),
+                     _mm512_set1_pd(view.center_lo.x)};
+  const __m512d w = _mm512_set1_pd(view.width());
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d half = _mm512_set1_pd(0.5);
+  const Dd cy = PixelY(view, y);
+  const Dd8 cy8{_mm512_set1_pd(cy.hi), _mm512_set1_pd(cy.lo)};
+
+  int x = x0;
+  for (; x + 8 <= x1; x += 8) {
+    __m512d px = _mm512_set_pd(x+7, x+6, x+5, x+4, x+3, x+2, x+1, x);
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    const Dd8 cx = Add(center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (x-x0)),
+                        _mm512_cvtpd_epi32(MandelbrotDdAvx512<kInteriorChecks>(
+                            cx, cy8, view.max_iter)));
+  }
+
+  if (x < x1) {
+    MandelbrotDdRowScalarImpl<kInteriorChecks>(view, y, x, x1, out + (x-x0));
+  }
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx512f")))
+void MandelbrotDdPointsAvx512Impl(const View& view, int n, const int* x,
+                                  const int* y, int* out) {
+  const Dd8 center_x{_mm512_set1_pd(view.center.x),
+                     _mm512_set1_pd(view.center_lo.x)};
+  const Dd8 center_y{_mm512_set1_pd(view.center.y),
+                     _mm512_set1_pd(view.center_lo.y)};
+  const __m512d w = _mm512_set1_pd(view.width());
+  const __m512d h = _mm512_set1_pd(view.height);
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d pixel_height = _mm512_set1_pd(view.pixel_height);
+  const __m512d half = _mm512_set1_pd(0.5);
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d px = _mm512_cvtepi32_pd(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+    __m512d py = _mm512_cvtepi32_pd(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)));
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    py = _mm512_div_pd(_mm512_add_pd(py, half), pixel_height);
+    const Dd8 cx = Add(center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+    const Dd8 cy = Add(center_y, _mm512_mul_pd(_mm512_sub_pd(py, half), h));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtpd_epi32(MandelbrotDdAvx512<kInteriorChecks>(
+                            cx, cy, view.max_iter)));
+  }
+
+  if (i < n) {
+    MandelbrotDdPointsScalarImpl<kInteriorChecks>(view, n - i, x + i, y + i,
+                                                  out + i);
+  }
+}
+
+}  // namespace
+
+
+void MandelbrotDdRowAvx2(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotDdRowAvx2Impl<true>(view, y, x0, x1, out);
+}
+
+
+void MandelbrotDdRowAvx512(const View& view, int y, int x0, int x1,
+                           int* out) {
+  MandelbrotDdRowAvx512Impl<true>(view, y, x0, x1, out);
+}
+
+
+__attribute__((target("avx2")))
+void NewtonDdRowAvx2(const Polynomial& polynomial, const View& view, int y,
+                     int x0, int x1, int* roots, int* steps) {
+  const int n = polynomial.degree();
+  __m256d coeff_x[Polynomial::kMaxDegree + 1];
+  __m256d coeff_y[Polynomial::kMaxDegree + 1];
+  __m256d root_x[Polynomial::kMaxDegree];
+  __m256d root_y[Polynomial::kMaxDegree];
+  for (int k = 0; k <= n; ++k) {
+    coeff_x[k] = _mm256_set1_pd(polynomial.coefficients()[k].real());
+    coeff_y[k] = _mm256_set1_pd(polynomial.coefficients()[k].imag());
+  }
+  for (int i = 0; i < n; ++i) {
+    root_x[i] = _mm256_set1_pd(polynomial.roots()[i].real());
+    root_y[i] = _mm256_set1_pd(polynomial.roots()[i].imag());
+  }
+
+  const Dd4 center_x{_mm256_set1_pd(view.center.x),
+                     _mm256_set1_pd(view.center_lo.x)};
+  const __m256d w = _mm256_set1_pd(view.width());
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d tolerance2 =
+      _mm256_set1_pd(kNewtonTolerance*kNewtonTolerance);
+  const __m256d radius2 = _mm256_set1_pd(kNewtonRootRadius*kNewtonRootRadius);
+  const Dd start_y = PixelY(view, y);
+
+  int x = x0;
+  for (; x + 4 <= x1; x += 4) {
+    __m256d px = _mm256_set_pd(x+3, x+2, x+1, x);
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    Dd4 zx = Add(center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+    Dd4 zy{_mm256_set1_pd(start_y.hi), _mm256_set1_pd(start_y.lo)};
+    __m256d root = _mm256_set1_pd(-1.0);
+    __m256d count = zero;
+    __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+    for (int iter = 0; iter < view.max_iter; ++iter) {
+      for (int i = 0; i < n; ++i) {
+        const __m256d ex = _mm256_sub_pd(zx.hi, root_x[i]);
+        const __m256d ey = _mm256_sub_pd(zy.hi, root_y[i]);
+        const __m256d hit = _mm256_and_pd(active, _mm256_cmp_pd(
+            _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey)),
+            tolerance2, _CMP_LT_OQ));
+        root = _mm256_blendv_pd(root, _mm256_set1_pd(i), hit);
+        active = _mm256_andnot_pd(hit, active);
+      }
+      if (_mm256_movemask_pd(active) == 0) {
+        break;
+      }
+
+      Dd4 fx{coeff_x[n], zero};
+      Dd4 fy{coeff_y[n], zero};
+      Dd4 dx{zero, zero};
+      Dd4 dy{zero, zero};
+      for (int k = n - 1; k >= 0; --k) {
+        const Dd4 ndx = Add(Sub(Mul(dx, zx), Mul(dy, zy)), fx);
+        dy = Add(Add(Mul(dx, zy), Mul(dy, zx)), fy);
+        dx = ndx;
+        const Dd4 nfx = Add(Sub(Mul(fx, zx), Mul(fy, zy)), coeff_x[k]);
+        fy = Add(Add(Mul(fx, zy), Mul(fy, zx)), coeff_y[k]);
+        fx = nfx;
+      }
+      const Dd4 d = Add(Sqr(dx), Sqr(dy));
+      const Dd4 sx = Div(Add(Mul(fx, dx), Mul(fy, dy)), d);
+      const Dd4 sy = Div(Sub(Mul(fy, dx), Mul(fx, dy)), d);
+      zx = Blend(zx, Sub(zx, sx), active);
+      zy = Blend(zy, Sub(zy, sy), active);
+      count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+      active = _mm256_andnot_pd(_mm256_cmp_pd(
+          _mm256_add_pd(_mm256_mul_pd(sx.hi, sx.hi),
+                        _mm256_mul_pd(sy.hi, sy.hi)),
+          tolerance2, _CMP_LT_OQ), active);
+    }
+
+    // Lanes that stopped without reaching a root's tolerance.
+    __m256d unresolved = _mm256_cmp_pd(root, zero, _CMP_LT_OQ);
+    for (int i = 0; i < n; ++i) {
+      const __m256d ex = _mm256_sub_pd(zx.hi, root_x[i]);
+      const __m256d ey = _mm256_sub_pd(zy.hi, root_y[i]);
+      const __m256d near = _mm256_and_pd(unresolved, _mm256_cmp_pd(
+          _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey)),
+          radius2, _CMP_LT_OQ));
+      root = _mm256_blendv_pd(root, _mm256_set1_pd(i), near);
+      unresolved = _mm256_andnot_pd(near, unresolved);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(roots + (x-x0)),
+                     _mm256_cvtpd_epi32(root));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(steps + (x-x0)),
+                     _mm256_cvtpd_epi32(count));
+  }
+
+  if (x < x1) {
+    NewtonDdRowScalar(polynomial, view, y, x, x1, roots + (x-x0),
+                      steps + (x-x0));
+  }
+}
+
+
+__attribute__((target("avx512f")))
+void NewtonDdRowAvx512(const Polynomial& polynomial, const View& view, int y,
+                       int x0, int x1, int* roots, int* steps) {
+  const int n = polynomial.degree();
+  __m512d coeff_x[Polynomial::kMaxDegree + 1];
+  __m512d coeff_y[Polynomial::kMaxDegree + 1];
+  __m512d root_x[Polynomial::kMaxDegree];
+  __m512d root_y[Polynomial::kMaxDegree];
+  for (int k = 0; k <= n; ++k) {
+    coeff_x[k] = _mm512_set1_pd(polynomial.coefficients()[k].real());
+    coeff_y[k] = _mm512_set1_pd(polynomial.coefficients()[k].imag());
+  }
+  for (int i = 0; i < n; ++i) {
+    root_x[i] = _mm512_set1_pd(polynomial.roots()[i].real());
+    root_y[i] = _mm512_set1_pd(polynomial.roots()[i].imag());
+  }
+
+  const Dd8 center_x{_mm512_set1_pd(view.center.x),
+                     _mm512_set1_pd(view.center_lo.x)};
+  const __m512d w = _mm512_set1_pd(view.width());
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d tolerance2 =
+      _mm512_set1_pd(kNewtonTolerance*kNewtonTolerance);
+  const __m512d radius2 = _mm512_set1_pd(kNewtonRootRadius*kNewtonRootRadius);
+  const Dd start_y = PixelY(view, y);
+
+  int x = x0;
+  for (; x + 8 <= x1; x += 8) {
+    __m512d px = _mm512_set_pd(x+7, x+6, x+5, x+4, x+3, x+2, x+1, x);
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    Dd8 zx = Add(center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+    Dd8 zy{_mm512_set1_pd(start_y.hi), _mm512_set1_pd(start_y.lo)};
+    __m512d root = _mm512_set1_pd(-1.0);
+    __m512d count = zero;
+    __mmask8 active = 0xff;
+
+    for (int iter = 0; iter < view.max_iter; ++iter) {
+      for (int i = 0; i < n; ++i) {
+        const __m512d ex = _mm512_sub_pd(zx.hi, root_x[i]);
+        const __m512d ey = _mm512_sub_pd(zy.hi, root_y[i]);
+        const __mmask8 hit = _mm512_mask_cmp_pd_mask(
+            active,
+            _mm512_add_pd(_mm512_mul_pd(ex, ex), _mm512_mul_pd(ey, ey)),
+            tolerance2, _CMP_LT_OQ);
+        root = _mm512_mask_mov_pd(root, hit, _mm512_set1_pd(i));
+        active &= ~hit;
+      }
+      if (active == 0) {
+        break;
+      }
+
+      Dd8 fx{coeff_x[n], zero};
+      Dd8 fy{coeff_y[n], zero};
+      Dd8 dx{zero, zero};
+      Dd8 dy{zero, zero};
+      for (int k = n - 1; k >= 0; --k) {
+        const Dd8 ndx = Add(Sub(Mul(dx, zx), Mul(dy, zy)), fx);
+        dy = Add(Add(Mul(dx, zy), Mul(dy, zx)), fy);
+        dx = ndx;
+        const Dd8 nfx = Add(Sub(Mul(fx, zx), Mul(fy, zy)), coeff_x[k]);
+        fy = Add(Add(Mul(fx, zy), Mul(fy, zx)), coeff_y[k]);
+        fx = nfx;
+      }
+      const Dd8 d = Add(Sqr(dx), Sqr(dy));
+      const Dd8 sx = Div(Add(Mul(fx, dx), Mul(fy, dy)), d);
+      const Dd8 sy = Div(Sub(Mul(fy, dx), Mul(fx, dy)), d);
+      zx = Blend(zx, Sub(zx, sx), active);
+      zy = Blend(zy, Sub(zy, sy), active);
+      count = _mm512_mask_add_pd(count, active, count, one);
+      active &= ~_mm512_cmp_pd_mask(
+          _mm512_add_pd(_mm512_mul_pd(sx.hi, sx.hi),
+                        _mm512_mul_pd(sy.hi, sy.hi)),
+          tolerance2, _CMP_LT_OQ);
+    }
+
+    // Lanes that stopped without reaching a root's tolerance.
+    __mmask8 unresolved = _mm512_cmp_pd_mask(root, zero, _CMP_LT_OQ);
+    for (int i = 0; i < n; ++i) {
+      const __m512d ex = _mm512_sub_pd(zx.hi, root_x[i]);
+      const __m512d ey = _mm512_sub_pd(zy.hi, root_y[i]);
+      const __mmask8 near = _mm512_mask_cmp_pd_mask(
+          unresolved,
+          _mm512_add_pd(_mm512_mul_pd(ex, ex), _mm512_mul_pd(ey, ey)),
+          radius2, _CMP_LT_OQ);
+      root = _mm512_mask_mov_pd(root, near, _mm512_set1_pd(i));
+      unresolved &= ~near;
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(roots + (x-x0)),
+                        _mm512_cvtpd_epi32(root));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(steps + (x-x0)),
+                        _mm512_cvtpd_epi32(count));
+  }
+
+  if (x < x1) {
+    NewtonDdRowScalar(polynomial, view, y, x, x1, roots + (x-x0),
+                      steps + (x-x0));
+  }
+}
+
+#else
+
+namespace {
+
+template <bool kInteriorChecks>
+void MandelbrotDdRowAvx2Impl(const View& view, int y, int x0, int x1,
+                             int* out) {
+  MandelbrotDdRowScalarImpl<kInteriorChecks>(view, y, x0, x1, out);
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotDdRowAvx512Impl(const View& view, int y, int x0, int x1,
+                               int* out) {
+  MandelbrotDdRowScalarImpl<kInteriorChecks>(view, y, x0, x1, out);
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotDdPointsAvx2Impl(const View& view, int n, const int* x,
+                                const int* y, int* out) {
+  MandelbrotDdPointsScalarImpl<kInteriorChecks>(view, n, x, y, out);
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotDdPointsAvx512Impl(const View& view, int n, const int* x,
+                                  const int* y, int* out) {
+  MandelbrotDdPointsScalarImpl<kInteriorChecks>(view, n, x, y, out);
+}
+
+}  // namespace
+
+
+void MandelbrotDdRowAvx2(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotDdRowScalar(view, y, x0, x1, out);
+}
+
+
+void MandelbrotDdRowAvx512(const View& view, int y, int x0, int x1,
+                           int* out) {
+  MandelbrotDdRowScalar(view, y, x0, x1, out);
+}
+
+
+void NewtonDdRowAvx2(const Polynomial& polynomial, const View& view, int y,
+                     int x0, int x1, int* roots, int* steps) {
+  NewtonDdRowScalar(polynomial, view, y, x0, x1, roots, steps);
+}
+
+
+void NewtonDdRowAvx512(const Polynomial& polynomial, const View& view, int y,
+                       int x0, int x1, int* roots, int* steps) {
+  NewtonDdRowScalar(polynomial, view, y, x0, x1, roots, steps);
+}
+
+#endif
+
+
+MandelbrotRowKernel GetMandelbrotDdRowKernel(Isa isa, bool interior_checks) {
+  if (interior_checks) {
+    switch (isa) {
+      case Isa::kAvx2: return &MandelbrotDdRowAvx2Impl<true>;
+      case Isa::kAvx512: return &MandelbrotDdRowAvx512Impl<true>;
+      default: return &MandelbrotDdRowScalarImpl<true>;
+    }
+  }
+  switch (isa) {
+    case Isa::kAvx2: return &MandelbrotDdRowAvx2Impl<false>;
+    case Isa::kAvx512: return &MandelbrotDdRowAvx512Impl<false>;
+    default: return &MandelbrotDdRowScalarImpl<false>;
+  }
+}
+
+
+MandelbrotPointsKernel GetMandelbrotDdPointsKernel(Isa isa,
+                                                   bool interior_checks) {
+  if (interior_checks) {
+    switch (isa) {
+      case Isa::kAvx2: return &MandelbrotDdPointsAvx2Impl<true>;
+      case Isa::kAvx512: return &MandelbrotDdPointsAvx512Impl<true>;
+      default: return &MandelbrotDdPointsScalarImpl<true>;
+    }
+  }
+  switch (isa) {
+    case Isa::kAvx2: return &MandelbrotDdPointsAvx2Impl<false>;
+    case Isa::kAvx512: return &MandelbrotDdPointsAvx512Impl<false>;
+    default: return &MandelbrotDdPointsScalarImpl<false>;
+  }
+}
+
+
+NewtonRowKernel GetNewtonDdRowKernel(Isa isa) {
+  switch (isa) {
+    case Isa::kAvx2: return &NewtonDdRowAvx2;
+    case Isa::kAvx512: return &NewtonDdRowAvx512;
+    default: return &NewtonDdRowScalar;
+  }
+}
@@ -0,0 +1,459 @@
+#include "fixed.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+
+namespace {
+
+using Limbs = std::vector<uint32_t>;
+
+
+int CompareMagnitude(const Limbs& a, const Limbs& b) {
+  for (size_t i = a.size(); i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+
+void AddMagnitude(const Limbs& a, const Limbs& b, Limbs& r) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    const uint64_t t = uint64_t{a[i]} + b[i] + carry;
+    r[i] = static_cast<uint32_t>(t);
+    carry = t >> 32;
+  }
+}
+
+
+// Requires |a| >= |b|.
+void SubMagnitude(const Limbs& a, const Limbs& b, Limbs& r) {
+  int64_t borrow = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    int64_t t = int64_t{a[i]} - b[i] - borrow;
+    borrow = t < 0;
+    r[i] = static_cast<uint32_t>(t + (borrow << 32));
+  }
+}
+
+
+// Below this many limbs the quadratic algorithms win over Karatsuba.
+constexpr size_t kKaratsubaThreshold = 48;
+
+
+// r[0 .. 2n) = a[0 .. n) * b[0 .. n).
+void MulSchoolbook(const uint32_t* a, const uint32_t* b, size_t n,
+                   uint32_t* r) {
+  std::fill(r, r + 2*n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < n; ++j) {
+      const uint64_t t = r[i+j] + uint64_t{a[i]}*b[j] + carry;
+      r[i+j] = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    r[i+n] = static_cast<uint32_t>(carry);
+  }
+}
+
+
+// r[0 .. 2n) = a[0 .. n)^2. Each cross product a_i a_j appears twice in a
+// square, so it is computed once and the sum is doubled.
+void SquareSchoolbook(const uint32_t* a, size_t n, uint32_t* r) {
+  std::fill(r, r + 2*n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t carry = 0;
+    for (size_t j = i + 1; j < n; ++j) {
+      const uint64_t t = r[i+j] + uint64_t{a[i]}*a[j] + carry;
+      r[i+j] = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    r[i+n] = static_cast<uint32_t>(carry);
+  }
+
+  uint32_t top = 0;
+  for (size_t i = 0; i < 2*n; ++i) {
+    const uint32_t next = r[i] >> 31;
+    r[i] = (r[i] << 1) | top;
+    top = next;
+  }
+
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t sq = uint64_t{a[i]}*a[i];
+    uint64_t t = uint64_t{r[2*i]} + static_cast<uint32_t>(sq) + carry;
+    r[2*i] = static_cast<uint32_t>(t);
+    t = uint64_t{r[2*i+1]} + (sq >> 32) + (t >> 32);
+    r[2*i+1] = static_cast<uint32_t>(t);
+    carry = t >> 32;
+  }
+}
+
+
+// r[0 .. n) += a[0 .. m), propagating the carry to the end of r.
+void AddInto(uint32_t* r, size_t n, const uint32_t* a, size_t m) {
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i < m; ++i) {
+    const uint64_t t = uint64_t{r[i]} + a[i] + carry;
+    r[i] = static_cast<uint32_t>(t);
+    carry = t >> 32;
+  }
+  for (; carry != 0 && i < n; ++i) {
+    const uint64_t t = uint64_t{r[i]} + carry;
+    r[i] = static_cast<uint32_t>(t);
+    carry = t >> 32;
+  }
+}
+
+
+// r[0 .. n) -= a[0 .. m); the result must not be negative.
+void SubFrom(uint32_t* r, size_t n, const uint32_t* a, size_t m) {
+  int64_t borrow = 0;
+  size_t i = 0;
+  for (; i < m; ++i) {
+    const int64_t t = int64_t{r[i]} - a[i] - borrow;
+    borrow = t < 0;
+    r[i] = static_cast<uint32_t>(t + (borrow << 32));
+  }
+  for (; borrow != 0 && i < n; ++i) {
+    const int64_t t = int64_t{r[i]} - borrow;
+    borrow = t < 0;
+    r[i] = static_cast<uint32_t>(t + (borrow << 32));
+  }
+}
+
+
+// Splits both operands into a low half of m limbs and a high half of
+// h = n - m limbs and forms the middle product from one multiplication of
+// the half sums: a0 b1 + a1 b0 = (a0 + a1)(b0 + b1) - a0 b0 - a1 b1.
+// Passing b == nullptr squares a.
+void Karatsuba(const uint32_t* a, const uint32_t* b, size_t n, uint32_t* r) {
+  if (n < kKaratsubaThreshold) {
+    if (b == nullptr) {
+      SquareSchoolbook(a, n, r);
+    }
+    else {
+      MulSchoolbook(a, b, n, r);
+    }
+    return;
+  }
+
+  const size_t m = n/2;
+  const size_t h = n - m;
+
+  // a0 b0 goes to r[0 .. 2m) and a1 b1 to r[2m .. 2n).
+  Karatsuba(a, b, m, r);
+  Karatsuba(a + m, b ? b + m : nullptr, h, r + 2*m);
+
+  std::vector<uint32_t> sum_a(h + 1, 0);
+  std::copy(a + m, a + n, sum_a.begin());
+  AddInto(sum_a.data(), h + 1, a, m);
+  std::vector<uint32_t> sum_b;
+  if (b != nullptr) {
+    sum_b.assign(h + 1, 0);
+    std::copy(b + m, b + n, sum_b.begin());
+    AddInto(sum_b.data(), h + 1, b, m);
+  }
+
+  std::vector<uint32_t> middle(2*(h + 1));
+  Karatsuba(sum_a.data(), b ? sum_b.data() : nullptr, h + 1, middle.data());
+  SubFrom(middle.data(), middle.size(), r, 2*m);
+  SubFrom(middle.data(), middle.size(), r + 2*m, 2*h);
+  AddInto(r + m, 2*n - m, middle.data(), std::min(middle.size(), 2*n - m));
+}
+
+
+// Product of two n-limb magnitudes, keeping the n limbs that line up with
+// the fixed point. Passing b == nullptr squares a.
+void MulMagnitude(const Limbs& a, const Limbs* b, Limbs& r) {
+  const size_t n = a.size();
+  Limbs product(2*n);
+  Karatsuba(a.data(), b ? b->data() : nullptr, n, product.data());
+  std::copy(product.begin() + (n-1), product.begin() + (2*n-1), r.begin());
+}
+
+
+// Brings both operands to the larger of their precisions, copying only
+// when they differ.
+template <typename F>
+Fixed Promoted(const Fixed& a, const Fixed& b, F f) {
+  if (a.frac_limbs() == b.frac_limbs()) {
+    return f(a, b);
+  }
+  const int n = std::max(a.frac_limbs(), b.frac_limbs());
+  Fixed pa = a;
+  Fixed pb = b;
+  pa.SetPrecision(n);
+  pb.SetPrecision(n);
+  return f(pa, pb);
+}
+
+}  // namespace
+
+
+Fixed::Fixed(double v, int frac_limbs) : limbs_(frac_limbs + 1, 0) {
+  negative_ = v < 0;
+  v = std::fabs(v);
+  if (v == 0.0) {
+    negative_ = false;
+    return;
+  }
+
+  int e;
+  const double m = std::frexp(v, &e);
+  uint64_t mantissa = static_cast<uint64_t>(std::ldexp(m, 53));
+  int pos = e - 53 + 32*frac_limbs;
+  if (pos < 0) {
+    mantissa = -pos < 64 ? mantissa >> -pos : 0;
+    pos = 0;
+  }
+
+  const unsigned __int128 wide =
+      static_cast<unsigned __int128>(mantissa) << (pos % 32);
+  for (int k = 0; k < 3; ++k) {
+    const size_t i = pos/32 + k;
+    if (i < limbs_.size()) {
+      limbs_[i] = static_cast<uint32_t>(wide >> (32*k));
+    }
+  }
+  if (is_zero()) {
+    negative_ = false;
+  }
+}
+
+
+bool Fixed::Parse(const std::string& s, int frac_limbs, Fixed* result) {
+  size_t i = 0;
+  bool negative = false;
+  if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+    negative = s[i++] == '-';
+  }
+
+  std::string digits;
+  long point = -1;
+  for (; i < s.size() && s[i] != 'e' && s[i] != 'E'; ++i) {
+    if (s[i] == '.' && point < 0) {
+      point = static_cast<long>(digits.size());
+    }
+    else if (s[i] >= '0' && s[i] <= '9') {
+      digits += s[i];
+    }
+    else {
+      return false;
+    }
+  }
+  if (digits.empty()) {
+    return false;
+  }
+  if (point < 0) {
+    point = static_cast<long>(digits.size());
+  }
+  if (i < s.size()) {
+    // strtol() would also skip leading spaces.
+    const std::string exponent = s.substr(i + 1);
+    char* end;
+    errno = 0;
+    const long e = std::strtol(exponent.c_str(), &end, 10);
+    if (exponent.empty() ||
+        std::isspace(static_cast<unsigned char>(exponent[0])) ||
+        *end != '\0' || errno == ERANGE || e < INT_MIN || e > INT_MAX) {
+      return false;
+    }
+    point += e;
+  }
+
+  // Leading zeros say nothing; past them the first digit fixes the size.
+  const size_t first = digits.find_first_not_of('0');
+  if (first == std::string::npos) {
+    digits.clear();
+    point = 0;
+  }
+  else {
+    digits.erase(0, first);
+    point -= static_cast<long>(first);
+  }
+  // Ten digits can exceed the 32-bit integer part; more always do.
+  if (point > 10) {
+    return false;
+  }
+  // Below about ten digits per fraction limb the number rounds to zero,
+  // which also bounds the padding for large negative exponents.
+  if (point < -10L*(frac_limbs + 2)) {
+    digits.clear();
+    point = 0;
+  }
+  if (point < 0) {
+    digits.insert(0, -point, '0');
+    point = 0;
+  }
+  if (point > static_cast<long>(digits.size())) {
+    digits.append(point - digits.size(), '0');
+  }
+
+  // Horner's rule from the last digit: f = (d + f)/10. One guard limb
+  // absorbs the truncation of the repeated divisions.
+  Fixed r(0.0, frac_limbs + 1);
+  auto& limbs = r.limbs_;
+  for (size_t k = digits.size(); k-- > static_cast<size_t>(point);) {
+    limbs.back() = digits[k] - '0';
+    uint64_t remainder = 0;
+    for (size_t j = limbs.size(); j-- > 0;) {
+      const uint64_t cur = (remainder << 32) | limbs[j];
+      limbs[j] = static_cast<uint32_t>(cur/10);
+      remainder = cur % 10;
+    }
+  }
+
+  uint64_t integer = 0;
+  for (long k = 0; k < point; ++k) {
+    integer = 10*integer + (digits[k] - '0');
+  }
+  if (integer > UINT32_MAX) {
+    return false;
+  }
+  limbs.back() = static_cast<uint32_t>(integer);
+
+  r.SetPrecision(frac_limbs);
+  r.negative_ = negative && !r.is_zero();
+  *result = r;
+  return true;
+}
+
+
+Fixed Fixed::FromString(const std::string& s, int frac_limbs) {
+  Fixed r(0.0, frac_limbs);
+  Parse(s, frac_limbs, &r);
+  return r;
+}
+
+
+double Fixed::ToDouble() const {
+  double r = 0.0;
+  int used = 0;
+  for (size_t i = limbs_.size(); i-- > 0 && used < 3;) {
+    if (limbs_[i] != 0 || used > 0) {
+      r += std::ldexp(static_cast<double>(limbs_[i]),
+                      32*(static_cast<int>(i) - frac_limbs()));
+      ++used;
+    }
+  }
+  return negative_ ? -r : r;
+}
+
+
+void Fixed::ToDoubleDouble(double* hi, double* lo) const {
+  *hi = ToDouble();
+  *lo = (*this - Fixed(*hi, frac_limbs())).ToDouble();
+}
+
+
+std::string Fixed::ToString(int digits) const {
+  std::string s = negative_ ? "-" : "";
+  s += std::to_string(limbs_.back());
+  s += '.';
+
+  Limbs fraction = limbs_;
+  for (int k = 0; k < digits; ++k) {
+    fraction.back() = 0;
+    uint64_t carry = 0;
+    for (auto& limb : fraction) {
+      const uint64_t t = uint64_t{limb}*10 + carry;
+      limb = static_cast<uint32_t>(t);
+      carry = t >> 32;
+    }
+    s += static_cast<char>('0' + fraction.back());
+  }
+  return s;
+}
+
+
+void Fixed::SetPrecision(int frac_limbs) {
+  const int delta = frac_limbs - this->frac_limbs();
+  if (delta > 0) {
+    limbs_.insert(limbs_.begin(), delta, 0);
+  }
+  else if (delta < 0) {
+    limbs_.erase(limbs_.begin(), limbs_.begin() - delta);
+    if (is_zero()) {
+      negative_ = false;
+    }
+  }
+}
+
+
+bool Fixed::is_zero() const {
+  return std::all_of(limbs_.begin(), limbs_.end(),
+                     [](uint32_t limb) { return limb == 0; });
+}
+
+
+Fixed operator+(const Fixed& a, const Fixed& b) {
+  return Promoted(a, b, [](const Fixed& x, const Fixed& y) {
+    Fixed r(0.0, x.frac_limbs());
+    if (x.negative_ == y.negative_) {
+      AddMagnitude(x.limbs_, y.limbs_, r.limbs_);
+      r.negative_ = x.negative_;
+    }
+    else if (CompareMagnitude(x.limbs_, y.limbs_) >= 0) {
+      SubMagnitude(x.limbs_, y.limbs_, r.limbs_);
+      r.negative_ = x.negative_;
+    }
+    else {
+      SubMagnitude(y.limbs_, x.limbs_, r.limbs_);
+      r.negative_ = y.negative_;
+    }
+    if (r.is_zero()) {
+      r.negative_ = false;
+    }
+    return r;
+  });
+}
+
+
+Fixed operator-(const Fixed& a, const Fixed& b) {
+  return a + (-b);
+}
+
+
+Fixed operator*(const Fixed& a, const Fixed& b) {
+  return Promoted(a, b, [](const Fixed& x, const Fixed& y) {
+    Fixed r(0.0, x.frac_limbs());
+    MulMagnitude(x.limbs_, &y.limbs_, r.limbs_);
+    r.negative_ = x.negative_ != y.negative_ && !r.is_zero();
+    return r;
+  });
+}
+
+
+Fixed Square(const Fixed& a) {
+  Fixed r(0.0, a.frac_limbs());
+  MulMagnitude(a.limbs_, nullptr, r.limbs_);
+  return r;
+}
+
+
+Fixed operator-(Fixed a) {
+  a.negative_ = !a.negative_ && !a.is_zero();
+  return a;
+}
+
+
+bool operator==(const Fixed& a, const Fixed& b) {
+  if (a.frac_limbs() != b.frac_limbs()) {
+    const int n = std::max(a.frac_limbs(), b.frac_limbs());
+    Fixed pa = a;
+    Fixed pb = b;
+    pa.SetPrecision(n);
+    pb.SetPrecision(n);
+    return pa == pb;
+  }
+  return a.negative_ == b.negative_ && a.limbs_ == b.limbs_;
+}
@@ -1,75 +1,567 @@
 #include "fractal.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <utility>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 
-Fractal::Fractal() {
+namespace {
+
+// Longest a frame may take while the camera moves before the resolution
+// drops further.
+constexpr double kFrameBudget = 1.0/30.0;
+constexpr int kMaxDivisor = 8;
+
+// The max_iter governor looks at this many pixels per side of a frame.
+constexpr int kProbeSize = 64;
+
+
+// The full center + center_lo of a view.
+BigComplex CenterOf(const View& view, int limbs) {
+  return {Fixed(view.center.x, limbs) + Fixed(view.center_lo.x, limbs),
+          Fixed(view.center.y, limbs) + Fixed(view.center_lo.y, limbs)};
+}
+
+}  // namespace
+
+
+Fractal::Fractal() : governor_(kFrameBudget) {
   CreateWindow();
   CreateFractalRect();
   LoadTextures();
   LoadShaders();
-  shader_ = shaders_["mandelbrot"].get();
+  CreateOrbitBuffer();
+  CreatePolynomialBuffer();
+  CreateFrameBuffer();
+  CreateProbes();
+  UpdatePrecision();
 
   time_ = glfwGetTime();
+  start_time_ = time_;
 }
 
 
 Fractal::~Fractal() {
+  PrintFrameStats();
+  // The timers delete their queries and the polynomial its buffer, which
+  // needs the context.
+  iteration_timer_.reset();
+  polynomial_buffer_.reset();
+  profiler_ = Profiler();
   glfwTerminate();
 }
 
 
 void Fractal::Render() {
-  double dt = glfwGetTime() - time_;
-  time_ = glfwGetTime();
+  if (!dirty_ && !Moving()) {
+    return;
+  }
+
+  ScopedTimer render_timer(profiler_, "render");
+  double dt = Now() - time_;
+  time_ = Now();
 
   // Zoom
   zoom_momentum_ *= glm::exp(-10*dt);
-  shader_->Use();
-  shader_->SetUniform(
-      "fractal_height",
-      fractal_height()*glm::exp(-zoom_momentum_*dt));
-  shader_->SetUniform("fractal_width", fractal_height()*aspect_ratio());
-  const auto dir = PixelToWorld(cursor_pos()) - fractal_center();
-  shader_->SetUniform(
-      "fractal_center",
-      fractal_center() + zoom_momentum_*dt*dir);
+  view_.height *= glm::exp(-zoom_momentum_*dt);
+  auto dir = view_.PixelToOffset(cursor_pos());
+  view_.Move(zoom_momentum_*dt*dir);
 
   if (zoom_key_held_) {
-    shader_->SetUniform(
-        "fractal_height",
-        fractal_height()*glm::exp(-dt));
-    shader_->SetUniform("fractal_width", fractal_height()*aspect_ratio());
-    const auto dir = PixelToWorld(cursor_pos()) - fractal_center();
-    shader_->SetUniform(
-        "fractal_center",
-        fractal_center() + dt*dir);
+    view_.height *= glm::exp(-dt);
+    dir = view_.PixelToOffset(cursor_pos());
+    view_.Move(dt*dir);
   }
 
   // Scroll
   scroll_momentum_ *= glm::exp(-5*dt);
-  shader_->SetUniform(
-      "fractal_center", fractal_center() + dt*scroll_momentum_);
+  view_.Move(dt*scroll_momentum_);
 
-  // Adjust max iterations
-  if (automatic_max_iter_) {
-    const int max_iter = glm::clamp(
-        -15*glm::log(0.1*fractal_width()), 10.0, 500.0);
-    shader_->SetUniform("max_iter", max_iter);
+  if (palette_cycling_) {
+    palette_offset_ = std::fmod(palette_offset_ + 0.1*dt, 1.0);
   }
 
-  // Draw
+  UpdateMaxIter();
+  if (recording_.is_open() && view_.max_iter != recorded_max_iter_) {
+    InputEvent event;
+    event.type = InputEvent::Type::kMaxIter;
+    event.time = glfwGetTime() - recording_start_;
+    event.args[0] = view_.max_iter;
+    WriteInputEvent(recording_, event);
+    recorded_max_iter_ = view_.max_iter;
+  }
+
+  // May enter deep mode, so before the orbit is brought up to date.
+  UpdatePrecision();
+  if (deep_mode_) {
+    ScopedTimer orbit_timer(profiler_, "orbit");
+    UpdateOrbit();
+  }
+
+  // Stop for good once the motion has faded below a fraction of a pixel.
+  if (!Moving()) {
+    zoom_momentum_ = 0.0;
+    scroll_momentum_ = {0.0, 0.0};
+  }
+
+  // Draw. Pans reuse the previous frame, so only zooms lower the
+  // resolution.
+  UpdateResolution(dt, Zooming());
+  View frame = view_;
+  glm::ivec2 shift;
   glBindVertexArray(fractal_vao_);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-  glfwSwapBuffers(window_);
+  if (resolution_divisor_ == 1 && SnapToLastFrame(frame, &shift)) {
+    ReprojectFrame(frame, shift);
+  }
+  else {
+    RenderFrame(frame);
+  }
+  ColorFrame();
+  {
+    ScopedTimer swap_timer(profiler_, "swap");
+    glfwSwapBuffers(window_);
+  }
+  last_frame_ = frame;
+  last_shader_ = shader_;
+  frame_valid_ = resolution_divisor_ == 1;
+
+  // Keep drawing until the refinement has reached full resolution, for as
+  // long as the palette cycles, and until the governor has seen the last
+  // frame.
+  dirty_ = resolution_divisor_ > 1 || palette_cycling_ || num_probes_ > 0;
+  ++frames_drawn_;
+
+  if (profiler_.EndFrame(time_)) {
+    profiler_.PrintReport(std::cout);
+    UpdateTitle();
+  }
+}
+
+
+void Fractal::UpdateResolution(double dt, bool zooming) {
+  if (!zooming) {
+    resolution_divisor_ = std::max(1, resolution_divisor_/2);
+    return;
+  }
+
+  // dt is the time since the previous frame, so only adapt between two
+  // consecutive zoom frames.
+  if (resolution_divisor_ == motion_divisor_) {
+    if (dt > kFrameBudget && motion_divisor_ < kMaxDivisor) {
+      motion_divisor_ *= 2;
+    }
+    else if (dt < 0.25*kFrameBudget && motion_divisor_ > 2) {
+      motion_divisor_ /= 2;
+    }
+  }
+  resolution_divisor_ = motion_divisor_;
 }
 
 
 void Fractal::HandleInput() {
-  glfwPollEvents();
+  if (dirty_ || Moving()) {
+    glfwPollEvents();
+    return;
+  }
+
+  const double t = glfwGetTime();
+  glfwWaitEvents();
+  time_ = glfwGetTime();
+  idle_seconds_ += time_ - t;
+}
+
+
+// The last frame can be reused if it was rendered by the same shader at the
+// same zoom, size and iteration limit. The center of `frame` is then moved
+// to the nearest whole pixel offset from it; the error of under half a
+// pixel is made up by later frames, as view_ itself is left alone.
+bool Fractal::SnapToLastFrame(View& frame, glm::ivec2* shift) const {
+  const View& last = last_frame_;
+  if (!frame_valid_ || last_shader_ != shader_ ||
+      last.height != frame.height || last.max_iter != frame.max_iter ||
+      last.pixel_width != frame.pixel_width ||
+      last.pixel_height != frame.pixel_height) {
+    return false;
+  }
+
+  const double pixel = frame.height/frame.pixel_height;
+  const glm::dvec2 offset = (frame.center - last.center) +
+                            (frame.center_lo - last.center_lo);
+  const glm::dvec2 delta = glm::round(offset/pixel);
+  if (std::abs(delta.x) >= frame.pixel_width ||
+      std::abs(delta.y) >= frame.pixel_height) {
+    return false;
+  }
+  *shift = glm::ivec2(delta);
+  frame.center = last.center;
+  frame.center_lo = last.center_lo;
+  frame.Move(delta*pixel);
+  return true;
+}
+
+
+void Fractal::RenderFrame(const View& frame) {
+  const int d = resolution_divisor_;
+  const int w = (frame.pixel_width + d - 1)/d;
+  const int h = (frame.pixel_height + d - 1)/d;
+  glBindFramebuffer(GL_FRAMEBUFFER, iteration_fbos_[current_frame_]);
+  glViewport(0, 0, w, h);
+  PushView(frame, d);
+  // Probed passes are timed for the governor already, which hands the
+  // times on to the profiler.
+  const bool probe = BeginProbe();
+  if (!probe) {
+    profiler_.BeginGpu("iterate");
+  }
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  if (probe) {
+    iteration_timer_->End();
+    profiler_.BeginGpu("probe");
+    EndProbe(frame, w, h);
+    profiler_.EndGpu("probe");
+  }
+  else {
+    profiler_.EndGpu("iterate");
+  }
+  pixels_computed_ += static_cast<long>(w)*h;
+}
+
+
+bool Fractal::BeginProbe() {
+  return automatic_max_iter_ && num_probes_ < GpuTimer::kQueries &&
+         iteration_timer_->Begin();
+}
+
+
+// Samples the width x height frame just drawn on a kProbeSize grid and
+// starts reading the samples back without waiting for them.
+void Fractal::EndProbe(const View& frame, int width, int height) {
+  FrameProbe& probe =
+      probes_[(first_probe_ + num_probes_) % GpuTimer::kQueries];
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, iteration_fbos_[current_frame_]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, probe_fbo_);
+  glBlitFramebuffer(0, 0, width, height, 0, 0, kProbeSize, kProbeSize,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, probe_fbo_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, probe.pixel_buffer);
+  glReadPixels(0, 0, kProbeSize, kProbeSize, GL_RG, GL_FLOAT, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  probe.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  probe.max_iter = frame.max_iter;
+  probe.pixels = static_cast<long>(width)*height;
+  probe.newton = coloring_ == 1;
+  ++num_probes_;
+}
+
+
+// Collects the probes the GPU has finished. Only the newest one counts; the
+// older ones were taken with a limit the governor has since moved on from.
+void Fractal::UpdateMaxIter() {
+  int latest = -1;
+  double seconds = 0.0;
+  while (num_probes_ > 0) {
+    FrameProbe& probe = probes_[first_probe_];
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(probe.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED || !iteration_timer_->Poll(&seconds)) {
+      break;
+    }
+    glDeleteSync(probe.fence);
+    probe.fence = nullptr;
+    profiler_.AddGpuSample("iterate", seconds);
+    latest = first_probe_;
+    first_probe_ = (first_probe_ + 1) % GpuTimer::kQueries;
+    --num_probes_;
+  }
+  if (latest < 0 || !automatic_max_iter_ || replaying_) {
+    return;
+  }
+
+  const FrameProbe& probe = probes_[latest];
+  view_.max_iter = governor_.Update(
+      ReadProbe(probe), probe.max_iter, seconds, probe.pixels,
+      static_cast<long>(view_.pixel_width)*view_.pixel_height);
+}
+
+
+// Mandelbrot and perturbation frames hold the smooth count and |z|, which
+// stays below 2 for pixels that never escaped; Newton frames hold the root
+// and the steps taken.
+IterationStats Fractal::ReadProbe(const FrameProbe& probe) const {
+  constexpr int kSamples = kProbeSize*kProbeSize;
+  IterationStats stats;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, probe.pixel_buffer);
+  const auto* data = static_cast<const float*>(glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, 2*kSamples*sizeof(float), GL_MAP_READ_BIT));
+  if (data != nullptr) {
+    for (int i = 0; i < kSamples; ++i) {
+      const float count = probe.newton ? data[2*i+1] : data[2*i];
+      const bool saturated = probe.newton ? count >= probe.max_iter
+                                          : data[2*i+1] < 2.0f;
+      if (saturated) {
+        ++stats.saturated;
+      }
+      else {
+        stats.escaped_sum += count;
+        stats.escaped_max = std::max<double>(stats.escaped_max, count);
+      }
+    }
+    stats.samples = kSamples;
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return stats;
+}
+
+
+// Pixel (x, y) of the new frame is pixel (x, y) + shift of the last one.
+// The overlap is copied across to the other texture and the rest drawn
+// under a scissor, one strip per axis.
+void Fractal::ReprojectFrame(const View& frame, glm::ivec2 shift) {
+  if (shift == glm::ivec2(0, 0)) {
+    return;
+  }
+  const int w = frame.pixel_width;
+  const int h = frame.pixel_height;
+  const int dx = shift.x;
+  const int dy = shift.y;
+  const int next = 1 - current_frame_;
+  profiler_.BeginGpu("reproject");
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, iteration_fbos_[current_frame_]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, iteration_fbos_[next]);
+  glBlitFramebuffer(std::max(0, dx), std::max(0, dy),
+                    std::min(w, w + dx), std::min(h, h + dy),
+                    std::max(0, -dx), std::max(0, -dy),
+                    std::min(w, w - dx), std::min(h, h - dy),
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  current_frame_ = next;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, iteration_fbos_[current_frame_]);
+  glViewport(0, 0, w, h);
+  PushView(frame, 1);
+  glEnable(GL_SCISSOR_TEST);
+  if (dx != 0) {
+    glScissor(dx > 0 ? w - dx : 0, 0, std::abs(dx), h);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    pixels_computed_ += static_cast<long>(std::abs(dx))*h;
+  }
+  if (dy != 0) {
+    glScissor(0, dy > 0 ? h - dy : 0, w, std::abs(dy));
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    pixels_computed_ += static_cast<long>(std::abs(dy))*w;
+  }
+  glDisable(GL_SCISSOR_TEST);
+  profiler_.EndGpu("reproject");
+}
+
+
+void Fractal::ColorFrame() {
+  const int d = resolution_divisor_;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, view_.pixel_width, view_.pixel_height);
+  glActiveTexture(GL_TEXTURE0 + 3);
+  glBindTexture(GL_TEXTURE_2D, iteration_textures_[current_frame_]);
+
+  const auto& u = color_uniforms_;
+  color_shader_->Use();
+  color_shader_->SetUniform(u.window_width, view_.pixel_width);
+  color_shader_->SetUniform(u.window_height, view_.pixel_height);
+  color_shader_->SetUniform(u.frame_width, (view_.pixel_width + d - 1)/d);
+  color_shader_->SetUniform(u.frame_height, (view_.pixel_height + d - 1)/d);
+  color_shader_->SetUniform(u.max_iter, view_.max_iter);
+  color_shader_->SetUniform(u.coloring, coloring_);
+  color_shader_->SetUniform(u.num_roots, polynomial_.degree());
+  color_shader_->SetUniform(u.palette, palette_);
+  color_shader_->SetUniform(u.smooth_coloring, smooth_coloring_ ? 1 : 0);
+  color_shader_->SetUniform(u.color_density, color_density_);
+  color_shader_->SetUniform(u.palette_offset, palette_offset_);
+  const int overlay = precision_overlay_ ? static_cast<int>(precision_) : -1;
+  color_shader_->SetUniform(u.precision_overlay, overlay);
+  profiler_.BeginGpu("color");
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  profiler_.EndGpu("color");
+}
+
+
+bool Fractal::Moving() const {
+  const double pixel = view_.height/view_.pixel_height;
+  return Zooming() || glm::length(scroll_momentum_) > 0.1*pixel;
+}
+
+
+bool Fractal::Zooming() const {
+  return zoom_key_held_ || std::abs(zoom_momentum_) > 1e-3;
+}
+
+
+void Fractal::PrintFrameStats() const {
+  const double elapsed = glfwGetTime() - start_time_;
+  std::cout << frames_drawn_ << " frames in " << elapsed << " s, idle for "
+            << idle_seconds_ << " s (" << 100.0*idle_seconds_/elapsed
+            << "%), " << pixels_computed_/std::max(1l, frames_drawn_)
+            << " pixels computed per frame" << std::endl;
+}
+
+
+void Fractal::SetProfiling(bool enabled) {
+  profiler_.set_enabled(enabled);
+  if (!enabled) {
+    UpdateTitle();
+  }
+}
+
+
+void Fractal::UpdateTitle() {
+  std::string title = "fractal";
+  if (precision_overlay_) {
+    title += " | ";
+    title += PrecisionName(precision_);
+  }
+  if (profiler_.enabled() && !profiler_.Summary().empty()) {
+    title += " | " + profiler_.Summary();
+  }
+  glfwSetWindowTitle(window_, title.c_str());
+}
+
+
+bool Fractal::StartRecording(const std::string& path) {
+  recording_.open(path);
+  if (!recording_) {
+    return false;
+  }
+  recording_start_ = glfwGetTime();
+  WriteSessionHeader(recording_);
+
+  // The state the session starts from.
+  InputEvent size;
+  size.type = InputEvent::Type::kWindowSize;
+  size.args[0] = view_.pixel_width;
+  size.args[1] = view_.pixel_height;
+  WriteInputEvent(recording_, size);
+  InputEvent cursor;
+  cursor.type = InputEvent::Type::kCursorPos;
+  glfwGetCursorPos(window_, &cursor.x, &cursor.y);
+  WriteInputEvent(recording_, cursor);
+  return true;
+}
+
+
+void Fractal::Replay(const std::vector<InputEvent>& events, double dt) {
+  using Clock = std::chrono::steady_clock;
+  glfwSwapInterval(0);
+  replaying_ = true;
+  replay_time_ = 0.0;
+  time_ = 0.0;
+  start_time_ = 0.0;
+
+  std::vector<double> frame_seconds;
+  size_t next = 0;
+  const auto start = Clock::now();
+  while (!ShouldClose() &&
+         (next < events.size() || Moving() || resolution_divisor_ > 1)) {
+    glfwPollEvents();
+    // Skip ahead over idle stretches, as glfwWaitEvents() would.
+    if (!dirty_ && !Moving() && next < events.size() &&
+        events[next].time > replay_time_) {
+      replay_time_ = events[next].time;
+      time_ = replay_time_;
+    }
+    while (next < events.size() && events[next].time <= replay_time_) {
+      HandleEvent(events[next++]);
+    }
+
+    // Waiting for the GPU makes the time that of the whole frame.
+    const long drawn = frames_drawn_;
+    const auto t = Clock::now();
+    Render();
+    glFinish();
+    if (frames_drawn_ > drawn) {
+      frame_seconds.push_back(
+          std::chrono::duration<double>(Clock::now() - t).count());
+    }
+    replay_time_ += dt;
+  }
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  replaying_ = false;
+
+  std::sort(frame_seconds.begin(), frame_seconds.end());
+  auto percentile = [&](double p) {
+    if (frame_seconds.empty()) {
+      return 0.0;
+    }
+    const size_t rank = std::min(frame_seconds.size() - 1,
+                                 static_cast<size_t>(p*frame_seconds.size()));
+    return 1e3*frame_seconds[rank];
+  };
+  double total = 0.0;
+  for (const double s : frame_seconds) {
+    total += s;
+  }
+  std::printf("replayed %zu events in %.2f s: %zu frames\n"
+              "frame time [ms]: mean %.2f, p50 %.2f, p90 %.2f, p99 %.2f, "
+              "max %.2f\n",
+              next, seconds, frame_seconds.size(),
+              1e3*total/std::max<size_t>(1, frame_seconds.size()),
+              percentile(0.5), percentile(0.9), percentile(0.99),
+              percentile(1.0));
+}
+
+
+void Fractal::OnEvent(InputEvent event) {
+  // Live input would make a replay diverge from its recording.
+  if (replaying_) {
+    return;
+  }
+  if (recording_.is_open()) {
+    event.time = glfwGetTime() - recording_start_;
+    WriteInputEvent(recording_, event);
+  }
+  HandleEvent(event);
+}
+
+
+void Fractal::HandleEvent(const InputEvent& event) {
+  const int* a = event.args;
+  switch (event.type) {
+    case InputEvent::Type::kCursorPos:
+      CursorPosCallback(event.x, event.y);
+      break;
+    case InputEvent::Type::kMouseButton:
+      MouseButtonCallback(a[0], a[1], a[2]);
+      break;
+    case InputEvent::Type::kWindowSize:
+      if (replaying_) {
+        glfwSetWindowSize(window_, a[0], a[1]);
+      }
+      WindowSizeCallback(a[0], a[1]);
+      break;
+    case InputEvent::Type::kScroll:
+      ScrollCallback(event.x, event.y);
+      break;
+    case InputEvent::Type::kKey:
+      KeyCallback(a[0], a[1], a[2], a[3]);
+      break;
+    case InputEvent::Type::kRefresh:
+      WindowRefreshCallback();
+      break;
+    case InputEvent::Type::kMaxIter:
+      view_.max_iter = a[0];
+      dirty_ = true;
+      break;
+  }
+}
+
+
+double Fractal::Now() const {
+  return replaying_ ? replay_time_ : glfwGetTime();
 }
 
 
@@ -84,7 +576,8 @@ void Fractal::CreateWindow() {
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-  window_ = glfwCreateWindow(600, 600, "fractal", NULL, NULL);
+  window_ = glfwCreateWindow(
+      view_.pixel_width, view_.pixel_height, "fractal", NULL, NULL);
   if (window_ == NULL)
   {
     std::cout << "Failed to create GLFW window" << std::endl;
@@ -102,7 +595,7 @@ void Fractal::CreateWindow() {
   }
 
 
-  glViewport(0, 0, 600, 600);
+  glViewport(0, 0, view_.pixel_width, view_.pixel_height);
 
   glfwSetWindowUserPointer(window_, this);
   glfwSetCursorPosCallback(window_, &cursor_pos_callback);
@@ -110,6 +603,7 @@ void Fractal::CreateWindow() {
   glfwSetWindowSizeCallback(window_, &window_size_callback);
   glfwSetScrollCallback(window_, &scroll_callback);
   glfwSetKeyCallback(window_, &key_callback);
+  glfwSetWindowRefreshCallback(window_, &window_refresh_callback);
 }
 
 
@@ -173,7 +667,13 @@ void Fractal::LoadTextures() {
 
 
 void Fractal::LoadShaders() {
-  std::vector<std::string> shader_names = {"mandelbrot", "newton"};
+  std::vector<std::string> shader_names = {
+    "mandelbrot", "mandelbrot_float", "mandelbrot_dd", "newton",
+    "newton_float", "newton_dd", "perturbation"};
+  double_float_supported_ = HasGlExtension("GL_ARB_gpu_shader5");
+  if (double_float_supported_) {
+    shader_names.push_back("mandelbrot_df");
+  }
 
   for (const auto& name : shader_names) {
     const auto frag_path = "shaders/" + name + ".frag";
@@ -181,100 +681,306 @@ void Fractal::LoadShaders() {
         "shaders/default.vert", frag_path.c_str());
 
     shaders_[name]->Use();
-    shaders_[name]->SetUniform("window_width", window_size().x);
-    shaders_[name]->SetUniform("window_height", window_size().y);
-    shaders_[name]->SetUniform("fractal_center", {0.0, 0.0});
-    shaders_[name]->SetUniform("fractal_width", 2.0*aspect_ratio());
-    shaders_[name]->SetUniform("fractal_height", 2.0);
-    shaders_[name]->SetUniform("max_iter", 50);
     shaders_[name]->SetUniform("pal0", 0);
     shaders_[name]->SetUniform("pal1", 1);
+    shaders_[name]->SetUniform("orbit", 2);
+    shaders_[name]->BindUniformBlock("Polynomial",
+                                     PolynomialBuffer::kBinding);
   }
+
+  color_shader_ = std::make_unique<Shader>(
+      "shaders/default.vert", "shaders/color.frag");
+  color_shader_->Use();
+  color_shader_->SetUniform("pal0", 0);
+  color_shader_->SetUniform("pal1", 1);
+  color_shader_->SetUniform("iterations", 3);
+  color_uniforms_ = {
+    color_shader_->GetUniform<int>("window_width"),
+    color_shader_->GetUniform<int>("window_height"),
+    color_shader_->GetUniform<int>("frame_width"),
+    color_shader_->GetUniform<int>("frame_height"),
+    color_shader_->GetUniform<int>("max_iter"),
+    color_shader_->GetUniform<int>("coloring"),
+    color_shader_->GetUniform<int>("num_roots"),
+    color_shader_->GetUniform<int>("palette"),
+    color_shader_->GetUniform<int>("smooth_coloring"),
+    color_shader_->GetUniform<float>("color_density"),
+    color_shader_->GetUniform<float>("palette_offset"),
+    color_shader_->GetUniform<int>("precision_overlay"),
+  };
 }
 
 
-double Fractal::fractal_width() const {
-  const auto loc = glGetUniformLocation(shader_->id, "fractal_width");
-  double w;
-  glGetUniformdv(shader_->id, loc, &w);
-  return w;
+void Fractal::CreateOrbitBuffer() {
+  glGenBuffers(1, &orbit_buffer_);
+  glGenTextures(1, &orbit_texture_);
+  glBindBuffer(GL_TEXTURE_BUFFER, orbit_buffer_);
+  glActiveTexture(GL_TEXTURE0 + 2);
+  glBindTexture(GL_TEXTURE_BUFFER, orbit_texture_);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, orbit_buffer_);
 }
 
 
-double Fractal::fractal_height() const {
-  const auto loc = glGetUniformLocation(shader_->id, "fractal_height");
-  double h;
-  glGetUniformdv(shader_->id, loc, &h);
-  return h;
+void Fractal::CreatePolynomialBuffer() {
+  polynomial_buffer_ = std::make_unique<PolynomialBuffer>();
+  SetPolynomial(polynomial_);
 }
 
 
-glm::dvec2 Fractal::fractal_center() const {
-  const auto loc = glGetUniformLocation(shader_->id, "fractal_center");
-  glm::dvec2 c;
-  glGetUniformdv(shader_->id, loc, &c.x);
-  return c;
+// The roots are found here, once per polynomial, rather than per pixel.
+void Fractal::SetPolynomial(const Polynomial& polynomial) {
+  polynomial_ = polynomial;
+  polynomial_buffer_->Upload(polynomial_);
+  frame_valid_ = false;
 }
 
 
-glm::dvec2 Fractal::window_size() const {
-  int w, h;
-  glfwGetWindowSize(window_, &w, &h);
-  return {w, h};
+void Fractal::CreateFrameBuffer() {
+  glGenFramebuffers(2, iteration_fbos_);
+  glGenTextures(2, iteration_textures_);
+  ResizeFrameBuffer();
+  for (int i = 0; i < 2; ++i) {
+    glBindFramebuffer(GL_FRAMEBUFFER, iteration_fbos_[i]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, iteration_textures_[i], 0);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
-glm::dvec2 Fractal::cursor_pos() const {
-  double xpos, ypos;
-  glfwGetCursorPos(window_, &xpos, &ypos);
-  return {xpos, ypos};
+void Fractal::CreateProbes() {
+  iteration_timer_ = std::make_unique<GpuTimer>();
+
+  glGenFramebuffers(1, &probe_fbo_);
+  glGenTextures(1, &probe_texture_);
+  glActiveTexture(GL_TEXTURE0 + 4);
+  glBindTexture(GL_TEXTURE_2D, probe_texture_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, kProbeSize, kProbeSize, 0, GL_RG,
+               GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, probe_fbo_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         probe_texture_, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  for (FrameProbe& probe : probes_) {
+    glGenBuffers(1, &probe.pixel_buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, probe.pixel_buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, 2*kProbeSize*kProbeSize*sizeof(float),
+                 nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 }
 
 
-double Fractal::aspect_ratio() const {
-  const auto size = window_size();
-  return size.x/size.y;
+void Fractal::ResizeFrameBuffer() {
+  glActiveTexture(GL_TEXTURE0 + 3);
+  for (int i = 0; i < 2; ++i) {
+    glBindTexture(GL_TEXTURE_2D, iteration_textures_[i]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, view_.pixel_width,
+                 view_.pixel_height, 0, GL_RG, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  frame_valid_ = false;
 }
 
 
-int Fractal::max_iter() const {
-  const auto loc = glGetUniformLocation(shader_->id, "max_iter");
-  int max_iter;
-  glGetUniformiv(shader_->id, loc, &max_iter);
-  return max_iter;
+void Fractal::UseShader(const std::string& name) {
+  shader_ = shaders_[name].get();
+  coloring_ = name.rfind("newton", 0) == 0 ? 1 : 0;
+  view_uniforms_ = {
+    shader_->GetUniform<int>("window_width"),
+    shader_->GetUniform<int>("window_height"),
+    shader_->GetUniform<glm::dvec2>("fractal_center"),
+    shader_->GetUniform<glm::dvec2>("fractal_center_lo"),
+    shader_->GetUniform<double>("fractal_width"),
+    shader_->GetUniform<double>("fractal_height"),
+    shader_->GetUniform<int>("max_iter"),
+    shader_->GetUniform<int>("orbit_length"),
+    shader_->GetUniform<glm::vec2>("float_center"),
+    shader_->GetUniform<glm::vec2>("float_center_lo"),
+    shader_->GetUniform<glm::vec2>("float_size"),
+  };
 }
 
 
-glm::dvec2 Fractal::PixelToWorld(glm::dvec2 p) const {
-  int window_width, window_height;
-  glfwGetWindowSize(window_, &window_width, &window_height);
-  double px = p.x/window_width;
-  double py = p.y/window_height;
-  glm::dvec2 c = fractal_center();
-  return {c.x + (px-0.5)*fractal_width(),
-          c.y + (0.5-py)*fractal_height()};
+void Fractal::SetDeepMode(bool enabled) {
+  if (enabled == deep_mode_) {
+    return;
+  }
+  if (enabled) {
+    const int limbs = Fixed::LimbsForBits(RequiredPrecision(view_));
+    origin_ = CenterOf(view_, limbs);
+    view_.center = {0.0, 0.0};
+    view_.center_lo = {0.0, 0.0};
+  }
+  else {
+    const glm::dvec2 offset = view_.center + view_.center_lo;
+    origin_.x.ToDoubleDouble(&view_.center.x, &view_.center_lo.x);
+    origin_.y.ToDoubleDouble(&view_.center.y, &view_.center_lo.y);
+    view_.Move(offset);
+  }
+  deep_mode_ = enabled;
 }
 
 
-glm::dvec2 Fractal::PixelToWorldDelta(glm::dvec2 p) const {
-  int window_width, window_height;
-  glfwGetWindowSize(window_, &window_width, &window_height);
-  double px = p.x/window_width;
-  double py = p.y/window_height;
-  return {px*fractal_width(), -py*fractal_height()};
+// Moves along float, double-float, double, double-double and perturbation
+// as the zoom crosses their ranges. Every step still tells the pixels
+// apart (see ChoosePrecision()), but its rounding differs, so a switch
+// changes the counts of some pixels near the boundary; `fractal_bench
+// precision` measures how many. The perturbation shader rebases pixels
+// rather than glitching or stopping where its reference escapes, so it is
+// safe to enter unasked. Newton has no double-float shader and stops at
+// double-double, and "perturbation" stays in deep mode.
+void Fractal::UpdatePrecision() {
+  View absolute = view_;
+  if (deep_mode_) {
+    absolute.center += glm::dvec2(origin_.x.ToDouble(), origin_.y.ToDouble());
+  }
+  Precision precision =
+      ChoosePrecision(absolute, double_float_ && fractal_ == "mandelbrot");
+  if (fractal_ == "perturbation") {
+    precision = Precision::kPerturbation;
+  }
+  else if (fractal_ == "newton") {
+    precision = std::min(precision, Precision::kDoubleDouble);
+  }
+  SetDeepMode(precision == Precision::kPerturbation);
+  if (precision == precision_ && fractal_ == shader_fractal_) {
+    return;
+  }
+
+  std::string name = "perturbation";
+  switch (precision) {
+    case Precision::kFloat:
+      name = fractal_ + "_float";
+      break;
+    case Precision::kDoubleFloat:
+      name = fractal_ + "_df";
+      break;
+    case Precision::kDouble:
+      name = fractal_;
+      break;
+    case Precision::kDoubleDouble:
+      name = fractal_ + "_dd";
+      break;
+    case Precision::kPerturbation:
+      break;
+  }
+  UseShader(name);
+  shader_fractal_ = fractal_;
+  if (precision != precision_) {
+    precision_ = precision;
+    UpdateTitle();
+  }
 }
 
 
-void Fractal::CursorPosCallback(double x, double y) {
-  int mouse_left = glfwGetMouseButton(window_, GLFW_MOUSE_BUTTON_LEFT);
+// Once the view has wandered off from the reference point, the offset is
+// folded into origin_ so that it stays small enough to be exact in double.
+void Fractal::UpdateOrbit() {
+  if (glm::length(view_.center) > view_.height) {
+    const int limbs = Fixed::LimbsForBits(RequiredPrecision(view_) + 64);
+    const BigComplex offset = CenterOf(view_, limbs);
+    origin_.x += offset.x;
+    origin_.y += offset.y;
+    view_.center = {0.0, 0.0};
+    view_.center_lo = {0.0, 0.0};
+    frame_valid_ = false;
+  }
+
+  if (orbit_.Update(origin_, view_)) {
+    if (orbit_.escaped && orbit_.length() <= view_.max_iter) {
+      FindReference();
+    }
+    frame_valid_ = false;
+    std::vector<double> data(2*orbit_.length());
+    for (int n = 0; n < orbit_.length(); ++n) {
+      data[2*n] = orbit_.re[n];
+      data[2*n+1] = orbit_.im[n];
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, orbit_buffer_);
+    glBufferData(GL_TEXTURE_BUFFER, data.size()*sizeof(double), data.data(),
+                 GL_DYNAMIC_DRAW);
+  }
+}
+
+
+// Pixels that outlive an early escaping reference have to rebase every
+// orbit length, so try points on a grid around the view center and move
+// origin_ to the one whose orbit lasts longest, stopping at the first that
+// does not escape. The grid spans one view height, which keeps the new
+// offset below the distance at which UpdateOrbit() folds it in.
+void Fractal::FindReference() {
+  constexpr int kGrid = 5;
+  const int limbs = Fixed::LimbsForBits(orbit_.precision);
+  BigComplex center = CenterOf(view_, limbs);
+  center.x += origin_.x;
+  center.y += origin_.y;
+
+  const double step = view_.height/(kGrid - 1);
+  ReferenceOrbit orbit;
+  for (int k = 0; k < kGrid*kGrid && orbit_.escaped; ++k) {
+    const glm::dvec2 delta((k % kGrid - kGrid/2)*step,
+                           (k / kGrid - kGrid/2)*step);
+    BigComplex c = center;
+    c.x += Fixed(delta.x, limbs);
+    c.y += Fixed(delta.y, limbs);
+    orbit.Compute(c, orbit_.precision, orbit_.max_iter);
+    if (orbit.length() > orbit_.length()) {
+      std::swap(orbit, orbit_);
+      origin_ = c;
+      view_.center = -delta;
+      view_.center_lo = {0.0, 0.0};
+    }
+  }
+}
+
 
+// The shaders map gl_FragCoord through window_width/height, so a reduced
+// viewport covers the same region of the plane with fewer pixels.
+void Fractal::PushView(const View& view, int divisor) const {
+  const auto& u = view_uniforms_;
+  shader_->Use();
+  shader_->SetUniform(u.window_width,
+                      (view.pixel_width + divisor - 1)/divisor);
+  shader_->SetUniform(u.window_height,
+                      (view.pixel_height + divisor - 1)/divisor);
+  shader_->SetUniform(u.fractal_center, view.center);
+  shader_->SetUniform(u.fractal_center_lo, view.center_lo);
+  shader_->SetUniform(u.fractal_width, view.width());
+  shader_->SetUniform(u.fractal_height, view.height);
+  shader_->SetUniform(u.max_iter, view.max_iter);
+  shader_->SetUniform(u.orbit_length, orbit_.length());
+  glm::vec2 center, center_lo;
+  SplitToFloats(view.center, &center, &center_lo);
+  shader_->SetUniform(u.float_center, center);
+  shader_->SetUniform(u.float_center_lo, center_lo);
+  shader_->SetUniform(u.float_size, glm::vec2(view.width(), view.height));
+}
+
+
+// Kept from the events rather than asked from GLFW, so that replays see
+// the recorded cursor.
+glm::dvec2 Fractal::cursor_pos() const {
+  return cursor_pixel_pos_;
+}
+
+
+void Fractal::CursorPosCallback(double x, double y) {
   glm::dvec2 new_pixel_pos{x, y};
-  glm::dvec2 world_delta = PixelToWorldDelta(cursor_pixel_pos_ - new_pixel_pos);
+  glm::dvec2 world_delta =
+      view_.PixelToWorldDelta(cursor_pixel_pos_ - new_pixel_pos);
 
-  if (mouse_left == GLFW_PRESS) {
-    shader_->SetUniform("fractal_center", fractal_center()+world_delta);
+  if (left_button_down_) {
+    view_.Move(world_delta);
     scroll_momentum_ = {0, 0};
     mouse_pressed_ = true;
+    dirty_ = true;
   }
   else if (mouse_pressed_ == true) {
     scroll_momentum_ = 100.0*world_delta;
@@ -282,11 +988,14 @@ void Fractal::CursorPosCallback(double x, double y) {
   }
 
   cursor_pixel_pos_ = {x, y};
-  cursor_world_pos_ = PixelToWorld({x, y});
+  cursor_world_pos_ = view_.PixelToWorld({x, y});
 }
 
 
 void Fractal::MouseButtonCallback(int button, int action, int mods) {
+  if (button == GLFW_MOUSE_BUTTON_LEFT) {
+    left_button_down_ = action == GLFW_PRESS;
+  }
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
     scroll_momentum_ = {0, 0};
   }
@@ -294,13 +1003,15 @@ void Fractal::MouseButtonCallback(int button, int action, int mods) {
 
 
 void Fractal::WindowSizeCallback(int width, int height) {
-  for (auto const& [name, shader] : shaders_) {
-    shader->Use();
-    shader->SetUniform("window_width", width);
-    shader->SetUniform("window_height", height);
-    shader->SetUniform("fractal_width", fractal_height()*aspect_ratio());
-  }
-  glViewport(0, 0, width, height);
+  view_.pixel_width = width;
+  view_.pixel_height = height;
+  ResizeFrameBuffer();
+  dirty_ = true;
+}
+
+
+void Fractal::WindowRefreshCallback() {
+  dirty_ = true;
 }
 
 
@@ -316,23 +1027,52 @@ void Fractal::ScrollCallback(double xoffset, double yoffset) {
 
 
 void Fractal::KeyCallback(int key, int scancode, int action, int mods) {
+  dirty_ = true;
   if (action == GLFW_PRESS) {
     switch (key) {
       case GLFW_KEY_ESCAPE:
         should_close_ = true;
         break;
       case GLFW_KEY_1:
-        shader_ = shaders_["mandelbrot"].get();
+        fractal_ = "mandelbrot";
+        UpdatePrecision();
         scroll_momentum_ = {0, 0};
         zoom_momentum_ = 0;
         break;
       case GLFW_KEY_2:
-        shader_ = shaders_["newton"].get();
+        fractal_ = "newton";
+        UpdatePrecision();
+        scroll_momentum_ = {0, 0};
+        zoom_momentum_ = 0;
+        break;
+      case GLFW_KEY_3:
+        fractal_ = "perturbation";
+        UpdatePrecision();
         scroll_momentum_ = {0, 0};
         zoom_momentum_ = 0;
         break;
+      case GLFW_KEY_MINUS:
+        if (polynomial_.degree() > 2) {
+          SetPolynomial(Polynomial::UnitRoots(polynomial_.degree() - 1));
+        }
+        break;
+      case GLFW_KEY_EQUAL:
+        if (polynomial_.degree() < Polynomial::kMaxDegree) {
+          SetPolynomial(Polynomial::UnitRoots(polynomial_.degree() + 1));
+        }
+        break;
+      case GLFW_KEY_R: {
+        std::vector<std::complex<double>> coefficients;
+        for (int k = 0; k < polynomial_.degree(); ++k) {
+          coefficients.emplace_back(2.0*std::rand()/RAND_MAX - 1.0,
+                                    2.0*std::rand()/RAND_MAX - 1.0);
+        }
+        coefficients.emplace_back(1.0);
+        SetPolynomial(Polynomial(std::move(coefficients)));
+        break;
+      }
       case GLFW_KEY_J:
-        shader_->SetUniform("max_iter", max_iter()+10);
+        view_.max_iter += 10;
         break;
       case GLFW_KEY_Z:
         zoom_key_held_ = true;
@@ -340,11 +1080,48 @@ void Fractal::KeyCallback(int key, int scancode, int action, int mods) {
       case GLFW_KEY_A:
         automatic_max_iter_ = !automatic_max_iter_;
         break;
+      case GLFW_KEY_COMMA:
+      case GLFW_KEY_PERIOD:
+        governor_.set_budget(governor_.budget()*
+                             (key == GLFW_KEY_COMMA ? 0.8 : 1.25));
+        std::cout << "frame budget " << 1e3*governor_.budget() << " ms"
+                  << std::endl;
+        break;
       case GLFW_KEY_K:
-        if (max_iter() > 10) {
-          shader_->SetUniform("max_iter", max_iter()-10);
+        if (view_.max_iter > 10) {
+          view_.max_iter -= 10;
         }
         break;
+      case GLFW_KEY_P:
+        palette_ = 1 - palette_;
+        break;
+      case GLFW_KEY_C:
+        palette_cycling_ = !palette_cycling_;
+        break;
+      case GLFW_KEY_S:
+        smooth_coloring_ = !smooth_coloring_;
+        break;
+      case GLFW_KEY_T:
+        SetProfiling(!profiler_.enabled());
+        break;
+      case GLFW_KEY_D:
+        if (!double_float_supported_) {
+          std::cout << "double-float needs GL_ARB_gpu_shader5" << std::endl;
+          break;
+        }
+        double_float_ = !double_float_;
+        UpdatePrecision();
+        break;
+      case GLFW_KEY_O:
+        precision_overlay_ = !precision_overlay_;
+        UpdateTitle();
+        break;
+      case GLFW_KEY_LEFT_BRACKET:
+        color_density_ /= 1.25f;
+        break;
+      case GLFW_KEY_RIGHT_BRACKET:
+        color_density_ *= 1.25f;
+        break;
     }
   }
   if (action == GLFW_RELEASE) {
@@ -358,30 +1135,55 @@ void Fractal::KeyCallback(int key, int scancode, int action, int mods) {
 
 
 static void cursor_pos_callback(GLFWwindow* w, double x, double y) {
-  Fractal* fractal = static_cast<Fractal*>(glfwGetWindowUserPointer(w));
-  fractal->CursorPosCallback(x, y);
+  InputEvent event;
+  event.type = InputEvent::Type::kCursorPos;
+  event.x = x;
+  event.y = y;
+  static_cast<Fractal*>(glfwGetWindowUserPointer(w))->OnEvent(event);
 }
 
 
 void mouse_button_callback(GLFWwindow* w, int button, int action, int mods) {
-  Fractal* fractal = static_cast<Fractal*>(glfwGetWindowUserPointer(w));
-  fractal->MouseButtonCallback(button, action, mods);
+  InputEvent event;
+  event.type = InputEvent::Type::kMouseButton;
+  event.args[0] = button;
+  event.args[1] = action;
+  event.args[2] = mods;
+  static_cast<Fractal*>(glfwGetWindowUserPointer(w))->OnEvent(event);
 }
 
 
 void window_size_callback(GLFWwindow* w, int width, int height) {
-  Fractal* fractal = static_cast<Fractal*>(glfwGetWindowUserPointer(w));
-  fractal->WindowSizeCallback(width, height);
+  InputEvent event;
+  event.type = InputEvent::Type::kWindowSize;
+  event.args[0] = width;
+  event.args[1] = height;
+  static_cast<Fractal*>(glfwGetWindowUserPointer(w))->OnEvent(event);
 }
 
 
 void scroll_callback(GLFWwindow* w, double xoffset, double yoffset) {
-  Fractal* fractal = static_cast<Fractal*>(glfwGetWindowUserPointer(w));
-  fractal->ScrollCallback(xoffset, yoffset);
+  InputEvent event;
+  event.type = InputEvent::Type::kScroll;
+  event.x = xoffset;
+  event.y = yoffset;
+  static_cast<Fractal*>(glfwGetWindowUserPointer(w))->OnEvent(event);
 }
 
 
 void key_callback(GLFWwindow* w, int key, int scancode, int action, int mods) {
-  Fractal* fractal = static_cast<Fractal*>(glfwGetWindowUserPointer(w));
-  fractal->KeyCallback(key, scancode, action, mods);
+  InputEvent event;
+  event.type = InputEvent::Type::kKey;
+  event.args[0] = key;
+  event.args[1] = scancode;
+  event.args[2] = action;
+  event.args[3] = mods;
+  static_cast<Fractal*>(glfwGetWindowUserPointer(w))->OnEvent(event);
+}
+
+
+void window_refresh_callback(GLFWwindow* w) {
+  InputEvent event;
+  event.type = InputEvent::Type::kRefresh;
+  static_cast<Fractal*>(glfwGetWindowUserPointer(w))->OnEvent(event);
 }
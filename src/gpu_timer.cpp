@@ -0,0 +1,51 @@
+#include "gpu_timer.hpp"
+
+#include <glad/glad.h>
+
+
+GpuTimer::GpuTimer() {
+  glGenQueries(kQueries, queries_);
+}
+
+
+GpuTimer::~GpuTimer() {
+  glDeleteQueries(kQueries, queries_);
+}
+
+
+bool GpuTimer::Begin() {
+  if (count_ == kQueries) {
+    return false;
+  }
+  glBeginQuery(GL_TIME_ELAPSED, queries_[(first_ + count_) % kQueries]);
+  running_ = true;
+  return true;
+}
+
+
+void GpuTimer::End() {
+  if (!running_) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  running_ = false;
+  ++count_;
+}
+
+
+bool GpuTimer::Poll(double* seconds) {
+  if (count_ == 0) {
+    return false;
+  }
+  GLint available = 0;
+  glGetQueryObjectiv(queries_[first_], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return false;
+  }
+  GLuint64 nanoseconds = 0;
+  glGetQueryObjectui64v(queries_[first_], GL_QUERY_RESULT, &nanoseconds);
+  first_ = (first_ + 1) % kQueries;
+  --count_;
+  *seconds = 1e-9*nanoseconds;
+  return true;
+}
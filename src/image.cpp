@@ -0,0 +1,136 @@
+#include "image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+
+namespace {
+
+const std::array<uint32_t, 256>& CrcTable() {
+  static const auto table = [] {
+    std::array<uint32_t, 256> t;
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      t[n] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+
+void PutBigEndian(std::vector<uint8_t>& out, uint32_t v) {
+  out.push_back(v >> 24);
+  out.push_back(v >> 16);
+  out.push_back(v >> 8);
+  out.push_back(v);
+}
+
+
+void WriteChunk(std::ofstream& file, const char* type,
+                const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> chunk;
+  PutBigEndian(chunk, static_cast<uint32_t>(data.size()));
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+
+  const auto& table = CrcTable();
+  uint32_t crc = 0xffffffffu;
+  for (size_t i = 4; i < chunk.size(); ++i) {
+    crc = table[(crc ^ chunk[i]) & 0xff] ^ (crc >> 8);
+  }
+  PutBigEndian(chunk, crc ^ 0xffffffffu);
+  file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+
+// The pixels go into stored (uncompressed) deflate blocks. That keeps the
+// writer dependency-free and fast; the files are as large as a PPM.
+bool WritePng(const std::string& path, const Image& image) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n',
+                                       0x1a, '\n'};
+  file.write(reinterpret_cast<const char*>(signature), 8);
+
+  std::vector<uint8_t> header;
+  PutBigEndian(header, image.width);
+  PutBigEndian(header, image.height);
+  header.insert(header.end(), {8, 6, 0, 0, 0});  // 8-bit RGBA.
+  WriteChunk(file, "IHDR", header);
+
+  // Every scanline is prefixed with filter type 0.
+  const size_t stride = static_cast<size_t>(image.width)*4;
+  std::vector<uint8_t> raw;
+  raw.reserve((stride + 1)*image.height);
+  for (int y = 0; y < image.height; ++y) {
+    raw.push_back(0);
+    const auto row = image.rgba.begin() + y*stride;
+    raw.insert(raw.end(), row, row + stride);
+  }
+
+  std::vector<uint8_t> zlib = {0x78, 0x01};
+  size_t pos = 0;
+  do {
+    const size_t len = std::min<size_t>(raw.size() - pos, 65535);
+    zlib.push_back(pos + len == raw.size() ? 1 : 0);
+    zlib.push_back(len & 0xff);
+    zlib.push_back(len >> 8);
+    zlib.push_back(~len & 0xff);
+    zlib.push_back((~len >> 8) & 0xff);
+    zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+    pos += len;
+  } while (pos < raw.size());
+
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (uint8_t byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  PutBigEndian(zlib, (b << 16) | a);
+  WriteChunk(file, "IDAT", zlib);
+  WriteChunk(file, "IEND", {});
+  return static_cast<bool>(file);
+}
+
+
+bool WritePpm(const std::string& path, const Image& image) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  file << "P6\n" << image.width << " " << image.height << "\n255\n";
+  std::vector<uint8_t> rgb;
+  rgb.reserve(static_cast<size_t>(image.width)*image.height*3);
+  for (size_t i = 0; i < image.rgba.size(); i += 4) {
+    rgb.insert(rgb.end(), &image.rgba[i], &image.rgba[i] + 3);
+  }
+  file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+  return static_cast<bool>(file);
+}
+
+
+bool EndsWith(const std::string& s, const std::string& suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+
+bool WriteImage(const std::string& path, const Image& image) {
+  if (EndsWith(path, ".png")) {
+    return WritePng(path, image);
+  }
+  if (EndsWith(path, ".ppm")) {
+    return WritePpm(path, image);
+  }
+  return false;
+}
@@ -0,0 +1,1079 @@
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FRACTAL_X86 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Pixel centers, computed like gl_FragCoord in the shaders.
+double PixelX(const View& view, double width, int x) {
+  return view.center.x + ((x + 0.5)/view.pixel_width - 0.5)*width;
+}
+
+
+double PixelY(const View& view, int y) {
+  return view.center.y + ((y + 0.5)/view.pixel_height - 0.5)*view.height;
+}
+
+
+// True inside the main cardioid or the period-2 bulb, whose points never
+// escape.
+bool InMainComponents(double cx, double cy) {
+  const double x = cx - 0.25;
+  const double y2 = cy*cy;
+  const double q = x*x + y2;
+  if (q*(q + x) <= 0.25*y2) {
+    return true;
+  }
+  const double x1 = cx + 1.0;
+  return x1*x1 + y2 <= 0.0625;
+}
+
+
+template <bool kInteriorChecks>
+int MandelbrotPoint(double cx, double cy, int max_iter) {
+  if (kInteriorChecks && InMainComponents(cx, cy)) {
+    return max_iter;
+  }
+  double x = 0.0;
+  double y = 0.0;
+  double saved_x = 0.0;
+  double saved_y = 0.0;
+  int next_save = 1;
+  int iter = 0;
+  while (iter < max_iter) {
+    const double x2 = x*x;
+    const double y2 = y*y;
+    if (!(x2 + y2 < 4.0)) {
+      break;
+    }
+    const double xy = x*y;
+    x = (x2 - y2) + cx;
+    y = 2.0*xy + cy;
+    ++iter;
+    if (kInteriorChecks) {
+      // Brent: compare against z saved at the last power of two. An exact
+      // repeat means the orbit is periodic and would reach max_iter anyway.
+      if (x == saved_x && y == saved_y) {
+        return max_iter;
+      }
+      if (iter == next_save) {
+        saved_x = x;
+        saved_y = y;
+        next_save *= 2;
+      }
+    }
+  }
+  return iter;
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotRowScalarImpl(const View& view, int y, int x0, int x1,
+                             int* out) {
+  const double width = view.width();
+  const double cy = PixelY(view, y);
+  for (int x = x0; x < x1; ++x) {
+    out[x-x0] = MandelbrotPoint<kInteriorChecks>(PixelX(view, width, x), cy,
+                                                 view.max_iter);
+  }
+}
+
+
+int NewtonPoint(const Polynomial& polynomial, double x, double y,
+                int max_iter, int* steps) {
+  const auto& c = polynomial.coefficients();
+  const auto& roots = polynomial.roots();
+  const int n = polynomial.degree();
+  const double tolerance2 = kNewtonTolerance*kNewtonTolerance;
+  int iter = 0;
+  while (iter < max_iter) {
+    for (int i = 0; i < n; ++i) {
+      const double ex = x - roots[i].real();
+      const double ey = y - roots[i].imag();
+      if (ex*ex + ey*ey < tolerance2) {
+        *steps = iter;
+        return i;
+      }
+    }
+
+    // f in (fx, fy) and f' in (dx, dy).
+    double fx = c[n].real();
+    double fy = c[n].imag();
+    double dx = 0.0;
+    double dy = 0.0;
+    for (int k = n - 1; k >= 0; --k) {
+      const double ndx = (dx*x - dy*y) + fx;
+      dy = (dx*y + dy*x) + fy;
+      dx = ndx;
+      const double nfx = (fx*x - fy*y) + c[k].real();
+      fy = (fx*y + fy*x) + c[k].imag();
+      fx = nfx;
+    }
+    const double d = dx*dx + dy*dy;
+    const double sx = (fx*dx + fy*dy)/d;
+    const double sy = (fy*dx - fx*dy)/d;
+    x -= sx;
+    y -= sy;
+    ++iter;
+    if (sx*sx + sy*sy < tolerance2) {
+      break;
+    }
+  }
+
+  *steps = iter;
+  const double radius2 = kNewtonRootRadius*kNewtonRootRadius;
+  for (int i = 0; i < n; ++i) {
+    const double ex = x - roots[i].real();
+    const double ey = y - roots[i].imag();
+    if (ex*ex + ey*ey < radius2) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotPointsScalarImpl(const View& view, int n, const int* x,
+                                const int* y, int* out) {
+  const double width = view.width();
+  for (int i = 0; i < n; ++i) {
+    out[i] = MandelbrotPoint<kInteriorChecks>(
+        PixelX(view, width, x[i]), PixelY(view, y[i]), view.max_iter);
+  }
+}
+
+
+// Pauldelbrot's criterion: once |Z_n + d_n| drops far below |Z_n| the
+// offset has lost the precision it needs relative to the reference.
+constexpr double kGlitchTolerance = 1e-6;
+
+}  // namespace
+
+
+int PerturbationPixel(const ReferenceOrbit& orbit, const BlaTable* bla,
+                      double dcx, double dcy, int max_iter) {
+  const int limit = std::min(max_iter, orbit.length());
+  double dx = 0.0;
+  double dy = 0.0;
+  int iter = 0;
+  while (iter < limit) {
+    const double ref_x = orbit.re[iter];
+    const double ref_y = orbit.im[iter];
+    const double zx = ref_x + dx;
+    const double zy = ref_y + dy;
+    const double r2 = zx*zx + zy*zy;
+    if (!(r2 < 4.0)) {
+      return iter;
+    }
+    if (r2 < kGlitchTolerance*(ref_x*ref_x + ref_y*ref_y)) {
+      return -1 - iter;
+    }
+    if (bla != nullptr) {
+      const BlaStep* step = bla->Lookup(iter, dx*dx + dy*dy, limit);
+      if (step != nullptr) {
+        const double nx = (step->ax*dx - step->ay*dy) +
+                          (step->bx*dcx - step->by*dcy);
+        dy = (step->ax*dy + step->ay*dx) + (step->bx*dcy + step->by*dcx);
+        dx = nx;
+        iter += step->length;
+        continue;
+      }
+    }
+    const double tx = 2.0*ref_x + dx;
+    const double ty = 2.0*ref_y + dy;
+    const double nx = (tx*dx - ty*dy) + dcx;
+    dy = (tx*dy + ty*dx) + dcy;
+    dx = nx;
+    ++iter;
+  }
+  // Still bounded, but the reference escaped first.
+  return limit < max_iter ? -1 - iter : iter;
+}
+
+
+Isa DetectIsa() {
+  if (IsaSupported(Isa::kAvx512)) {
+    return Isa::kAvx512;
+  }
+  if (IsaSupported(Isa::kAvx2)) {
+    return Isa::kAvx2;
+  }
+  return Isa::kScalar;
+}
+
+
+bool IsaSupported(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+#ifdef FRACTAL_X86
+    case Isa::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case Isa::kAvx512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+
+const char* IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar: return "scalar";
+    case Isa::kAvx2: return "avx2";
+    case Isa::kAvx512: return "avx512";
+  }
+  return "unknown";
+}
+
+
+PerturbationRowKernel GetPerturbationRowKernel(Isa isa) {
+  switch (isa) {
+    case Isa::kAvx2: return &PerturbationRowAvx2;
+    case Isa::kAvx512: return &PerturbationRowAvx512;
+    default: return &PerturbationRowScalar;
+  }
+}
+
+
+NewtonRowKernel GetNewtonRowKernel(Isa isa) {
+  switch (isa) {
+    case Isa::kAvx2: return &NewtonRowAvx2;
+    case Isa::kAvx512: return &NewtonRowAvx512;
+    default: return &NewtonRowScalar;
+  }
+}
+
+
+void MandelbrotRowScalar(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotRowScalarImpl<true>(view, y, x0, x1, out);
+}
+
+
+void NewtonRowScalar(const Polynomial& polynomial, const View& view, int y,
+                     int x0, int x1, int* roots, int* steps) {
+  const double width = view.width();
+  const double zy = PixelY(view, y);
+  for (int x = x0; x < x1; ++x) {
+    roots[x-x0] = NewtonPoint(polynomial, PixelX(view, width, x), zy,
+                              view.max_iter, &steps[x-x0]);
+  }
+}
+
+
+void PerturbationRowScalar(const ReferenceOrbit& orbit, const BlaTable* bla,
+                           const View& view, int y, int x0, int x1,
+                           int* out) {
+  const double width = view.width();
+  const double dcy = PixelY(view, y);
+  for (int x = x0; x < x1; ++x) {
+    out[x-x0] = PerturbationPixel(
+        orbit, bla, PixelX(view, width, x), dcy, view.max_iter);
+  }
+}
+
+
+#ifdef FRACTAL_X86
+
+// The SIMD variants only use separate multiplies and adds (this file is
+// built with -ffp-contract=off) so that every lane rounds exactly like
+// MandelbrotPoint(). Lanes that escape stop counting but keep iterating
+// until the whole vector is done. Interior and periodic lanes are dropped
+// from `active` like escaped ones and get max_iter at the end.
+
+namespace {
+
+// Iteration counts of the four points (cx, cy).
+template <bool kInteriorChecks>
+__attribute__((target("avx2")))
+__m256d MandelbrotAvx2(__m256d cx, __m256d cy, int max_iter) {
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d quarter = _mm256_set1_pd(0.25);
+  const __m256d sixteenth = _mm256_set1_pd(0.0625);
+
+  __m256d zx = _mm256_setzero_pd();
+  __m256d zy = _mm256_setzero_pd();
+  __m256d count = _mm256_setzero_pd();
+  __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  __m256d inside = _mm256_setzero_pd();
+  __m256d saved_x = _mm256_setzero_pd();
+  __m256d saved_y = _mm256_setzero_pd();
+  int next_save = 1;
+
+  if (kInteriorChecks) {
+    const __m256d qx = _mm256_sub_pd(cx, quarter);
+    const __m256d cy2 = _mm256_mul_pd(cy, cy);
+    const __m256d q = _mm256_add_pd(_mm256_mul_pd(qx, qx), cy2);
+    const __m256d bx = _mm256_add_pd(cx, one);
+    inside = _mm256_or_pd(
+        _mm256_cmp_pd(_mm256_mul_pd(q, _mm256_add_pd(q, qx)),
+                      _mm256_mul_pd(quarter, cy2), _CMP_LE_OQ),
+        _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(bx, bx), cy2),
+                      sixteenth, _CMP_LE_OQ));
+    active = _mm256_andnot_pd(inside, active);
+  }
+
+  for (int i = 0; i < max_iter; ++i) {
+    const __m256d x2 = _mm256_mul_pd(zx, zx);
+    const __m256d y2 = _mm256_mul_pd(zy, zy);
+    active = _mm256_and_pd(
+        active, _mm256_cmp_pd(_mm256_add_pd(x2, y2), four, _CMP_LT_OQ));
+    if (_mm256_movemask_pd(active) == 0) {
+      break;
+    }
+    count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+    const __m256d xy = _mm256_mul_pd(zx, zy);
+    zx = _mm256_add_pd(_mm256_sub_pd(x2, y2), cx);
+    zy = _mm256_add_pd(_mm256_mul_pd(two, xy), cy);
+    if (kInteriorChecks) {
+      const __m256d repeat = _mm256_and_pd(
+          active, _mm256_and_pd(_mm256_cmp_pd(zx, saved_x, _CMP_EQ_OQ),
+                                _mm256_cmp_pd(zy, saved_y, _CMP_EQ_OQ)));
+      inside = _mm256_or_pd(inside, repeat);
+      active = _mm256_andnot_pd(repeat, active);
+      if (i + 1 == next_save) {
+        saved_x = zx;
+        saved_y = zy;
+        next_save *= 2;
+      }
+    }
+  }
+
+  if (kInteriorChecks) {
+    count = _mm256_blendv_pd(count, _mm256_set1_pd(max_iter), inside);
+  }
+  return count;
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx2")))
+void MandelbrotRowAvx2Impl(const View& view, int y, int x0, int x1,
+                           int* out) {
+  const __m256d center_x = _mm256_set1_pd(view.center.x);
+  const __m256d w = _mm256_set1_pd(view.width());
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d cy = _mm256_set1_pd(PixelY(view, y));
+
+  int x = x0;
+  for (; x + 4 <= x1; x += 4) {
+    __m256d px = _mm256_set_pd(x+3, x+2, x+1, x);
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    const __m256d cx = _mm256_add_pd(
+        center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (x-x0)),
+                     _mm256_cvtpd_epi32(MandelbrotAvx2<kInteriorChecks>(
+                         cx, cy, view.max_iter)));
+  }
+
+  if (x < x1) {
+    MandelbrotRowScalarImpl<kInteriorChecks>(view, y, x, x1, out + (x-x0));
+  }
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx2")))
+void MandelbrotPointsAvx2Impl(const View& view, int n, const int* x,
+                              const int* y, int* out) {
+  const __m256d center_x = _mm256_set1_pd(view.center.x);
+  const __m256d center_y = _mm256_set1_pd(view.center.y);
+  const __m256d w = _mm256_set1_pd(view.width());
+  const __m256d h = _mm256_set1_pd(view.height);
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d pixel_height = _mm256_set1_pd(view.pixel_height);
+  const __m256d half = _mm256_set1_pd(0.5);
+
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d px = _mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    __m256d py = _mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    py = _mm256_div_pd(_mm256_add_pd(py, half), pixel_height);
+    const __m256d cx = _mm256_add_pd(
+        center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+    const __m256d cy = _mm256_add_pd(
+        center_y, _mm256_mul_pd(_mm256_sub_pd(py, half), h));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm256_cvtpd_epi32(MandelbrotAvx2<kInteriorChecks>(
+                         cx, cy, view.max_iter)));
+  }
+
+  if (i < n) {
+    MandelbrotPointsScalarImpl<kInteriorChecks>(view, n - i, x + i, y + i,
+                                                out + i);
+  }
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx512f")))
+__m512d MandelbrotAvx512(__m512d cx, __m512d cy, int max_iter) {
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d four = _mm512_set1_pd(4.0);
+  const __m512d quarter = _mm512_set1_pd(0.25);
+  const __m512d sixteenth = _mm512_set1_pd(0.0625);
+
+  __m512d zx = _mm512_setzero_pd();
+  __m512d zy = _mm512_setzero_pd();
+  __m512d count = _mm512_setzero_pd();
+  __mmask8 active = 0xff;
+  __mmask8 inside = 0;
+  __m512d saved_x = _mm512_setzero_pd();
+  __m512d saved_y = _mm512_setzero_pd();
+  int next_save = 1;
+
+  if (kInteriorChecks) {
+    const __m512d qx = _mm512_sub_pd(cx, quarter);
+    const __m512d cy2 = _mm512_mul_pd(cy, cy);
+    const __m512d q = _mm512_add_pd(_mm512_mul_pd(qx, qx), cy2);
+    const __m512d bx = _mm512_add_pd(cx, one);
+    inside = _mm512_cmp_pd_mask(_mm512_mul_pd(q, _mm512_add_pd(q, qx)),
+                                _mm512_mul_pd(quarter, cy2), _CMP_LE_OQ) |
+             _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(bx, bx), cy2),
+                                sixteenth, _CMP_LE_OQ);
+    active &= ~inside;
+  }
+
+  for (int i = 0; i < max_iter; ++i) {
+    const __m512d x2 = _mm512_mul_pd(zx, zx);
+    const __m512d y2 = _mm512_mul_pd(zy, zy);
+    active = _mm512_mask_cmp_pd_mask(
+        active, _mm512_add_pd(x2, y2), four, _CMP_LT_OQ);
+    if (active == 0) {
+      break;
+    }
+    count = _mm512_mask_add_pd(count, active, count, one);
+    const __m512d xy = _mm512_mul_pd(zx, zy);
+    zx = _mm512_add_pd(_mm512_sub_pd(x2, y2), cx);
+    zy = _mm512_add_pd(_mm512_mul_pd(two, xy), cy);
+    if (kInteriorChecks) {
+      const __mmask8 repeat =
+          _mm512_mask_cmp_pd_mask(active, zx, saved_x, _CMP_EQ_OQ) &
+          _mm512_mask_cmp_pd_mask(active, zy, saved_y, _CMP_EQ_OQ);
+      inside |= repeat;
+      active &= ~repeat;
+      if (i + 1 == next_save) {
+        saved_x = zx;
+        saved_y = zy;
+        next_save *= 2;
+      }
+    }
+  }
+
+  if (kInteriorChecks) {
+    count = _mm512_mask_mov_pd(count, inside, _mm512_set1_pd(max_iter));
+  }
+  return count;
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx512f")))
+void MandelbrotRowAvx512Impl(const View& view, int y, int x0, int x1,
+                             int* out) {
+  const __m512d center_x = _mm512_set1_pd(view.center.x);
+  const __m512d w = _mm512_set1_pd(view.width());
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d cy = _mm512_set1_pd(PixelY(view, y));
+
+  int x = x0;
+  for (; x + 8 <= x1; x += 8) {
+    __m512d px = _mm512_set_pd(x+7, x+6, x+5, x+4, x+3, x+2, x+1, x);
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    const __m512d cx = _mm512_add_pd(
+        center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (x-x0)),
+                        _mm512_cvtpd_epi32(MandelbrotAvx512<kInteriorChecks>(
+                            cx, cy, view.max_iter)));
+  }
+
+  if (x < x1) {
+    MandelbrotRowScalarImpl<kInteriorChecks>(view, y, x, x1, out + (x-x0));
+  }
+}
+
+
+template <bool kInteriorChecks>
+__attribute__((target("avx512f")))
+void MandelbrotPointsAvx512Impl(const View& view, int n, const int* x,
+                                const int* y, int* out) {
+  const __m512d center_x = _mm512_set1_pd(view.center.x);
+  const __m512d center_y = _mm512_set1_pd(view.center.y);
+  const __m512d w = _mm512_set1_pd(view.width());
+  const __m512d h = _mm512_set1_pd(view.height);
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d pixel_height = _mm512_set1_pd(view.pixel_height);
+  const __m512d half = _mm512_set1_pd(0.5);
+
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d px = _mm512_cvtepi32_pd(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+    __m512d py = _mm512_cvtepi32_pd(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)));
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    py = _mm512_div_pd(_mm512_add_pd(py, half), pixel_height);
+    const __m512d cx = _mm512_add_pd(
+        center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+    const __m512d cy = _mm512_add_pd(
+        center_y, _mm512_mul_pd(_mm512_sub_pd(py, half), h));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtpd_epi32(MandelbrotAvx512<kInteriorChecks>(
+                            cx, cy, view.max_iter)));
+  }
+
+  if (i < n) {
+    MandelbrotPointsScalarImpl<kInteriorChecks>(view, n - i, x + i, y + i,
+                                                out + i);
+  }
+}
+
+}  // namespace
+
+
+void MandelbrotRowAvx2(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotRowAvx2Impl<true>(view, y, x0, x1, out);
+}
+
+
+void MandelbrotRowAvx512(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotRowAvx512Impl<true>(view, y, x0, x1, out);
+}
+
+
+// In the perturbation kernels all lanes sit at the same orbit index, so
+// Z_n is simply broadcast.
+
+__attribute__((target("avx2")))
+void PerturbationRowAvx2(const ReferenceOrbit& orbit, const BlaTable* bla,
+                         const View& view, int y, int x0, int x1, int* out) {
+  const double width = view.width();
+  const int limit = std::min(view.max_iter, orbit.length());
+  const __m256d center_x = _mm256_set1_pd(view.center.x);
+  const __m256d w = _mm256_set1_pd(width);
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d dcy = _mm256_set1_pd(PixelY(view, y));
+
+  int x = x0;
+  for (; x + 4 <= x1; x += 4) {
+    __m256d px = _mm256_set_pd(x+3, x+2, x+1, x);
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    const __m256d dcx = _mm256_add_pd(
+        center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+
+    __m256d dx = _mm256_setzero_pd();
+    __m256d dy = _mm256_setzero_pd();
+    __m256d count = _mm256_setzero_pd();
+    __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    __m256d glitched = _mm256_setzero_pd();
+
+    int n = 0;
+    while (n < limit) {
+      const __m256d ref_x = _mm256_set1_pd(orbit.re[n]);
+      const __m256d ref_y = _mm256_set1_pd(orbit.im[n]);
+      const __m256d zx = _mm256_add_pd(ref_x, dx);
+      const __m256d zy = _mm256_add_pd(ref_y, dy);
+      const __m256d r2 = _mm256_add_pd(_mm256_mul_pd(zx, zx),
+                                       _mm256_mul_pd(zy, zy));
+      active = _mm256_and_pd(active, _mm256_cmp_pd(r2, four, _CMP_LT_OQ));
+      const __m256d tolerance = _mm256_set1_pd(
+          kGlitchTolerance*(orbit.re[n]*orbit.re[n] + orbit.im[n]*orbit.im[n]));
+      const __m256d glitch = _mm256_and_pd(
+          active, _mm256_cmp_pd(r2, tolerance, _CMP_LT_OQ));
+      glitched = _mm256_or_pd(glitched, glitch);
+      active = _mm256_andnot_pd(glitch, active);
+      if (_mm256_movemask_pd(active) == 0) {
+        break;
+      }
+
+      if (bla != nullptr) {
+        alignas(32) double d2[4];
+        _mm256_store_pd(d2, _mm256_and_pd(active, _mm256_add_pd(
+            _mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+        const BlaStep* step = bla->Lookup(
+            n, std::max({d2[0], d2[1], d2[2], d2[3]}), limit);
+        if (step != nullptr) {
+          const __m256d ax = _mm256_set1_pd(step->ax);
+          const __m256d ay = _mm256_set1_pd(step->ay);
+          const __m256d bx = _mm256_set1_pd(step->bx);
+          const __m256d by = _mm256_set1_pd(step->by);
+          const __m256d nx = _mm256_add_pd(
+              _mm256_sub_pd(_mm256_mul_pd(ax, dx), _mm256_mul_pd(ay, dy)),
+              _mm256_sub_pd(_mm256_mul_pd(bx, dcx), _mm256_mul_pd(by, dcy)));
+          dy = _mm256_add_pd(
+              _mm256_add_pd(_mm256_mul_pd(ax, dy), _mm256_mul_pd(ay, dx)),
+              _mm256_add_pd(_mm256_mul_pd(bx, dcy), _mm256_mul_pd(by, dcx)));
+          dx = nx;
+          count = _mm256_add_pd(count, _mm256_and_pd(
+              active, _mm256_set1_pd(step->length)));
+          n += step->length;
+          continue;
+        }
+      }
+
+      count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+      const __m256d tx = _mm256_add_pd(_mm256_add_pd(ref_x, ref_x), dx);
+      const __m256d ty = _mm256_add_pd(_mm256_add_pd(ref_y, ref_y), dy);
+      const __m256d nx = _mm256_add_pd(
+          _mm256_sub_pd(_mm256_mul_pd(tx, dx), _mm256_mul_pd(ty, dy)), dcx);
+      dy = _mm256_add_pd(
+          _mm256_add_pd(_mm256_mul_pd(tx, dy), _mm256_mul_pd(ty, dx)), dcy);
+      dx = nx;
+      ++n;
+    }
+
+    if (limit < view.max_iter && n >= limit) {
+      glitched = _mm256_or_pd(glitched, active);
+    }
+    count = _mm256_blendv_pd(
+        count, _mm256_sub_pd(_mm256_set1_pd(-1.0), count), glitched);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (x-x0)),
+                     _mm256_cvtpd_epi32(count));
+  }
+
+  if (x < x1) {
+    PerturbationRowScalar(orbit, bla, view, y, x, x1, out + (x-x0));
+  }
+}
+
+
+__attribute__((target("avx512f")))
+void PerturbationRowAvx512(const ReferenceOrbit& orbit, const BlaTable* bla,
+                           const View& view, int y, int x0, int x1,
+                           int* out) {
+  const double width = view.width();
+  const int limit = std::min(view.max_iter, orbit.length());
+  const __m512d center_x = _mm512_set1_pd(view.center.x);
+  const __m512d w = _mm512_set1_pd(width);
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d four = _mm512_set1_pd(4.0);
+  const __m512d dcy = _mm512_set1_pd(PixelY(view, y));
+
+  int x = x0;
+  for (; x + 8 <= x1; x += 8) {
+    __m512d px = _mm512_set_pd(x+7, x+6, x+5, x+4, x+3, x+2, x+1, x);
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    const __m512d dcx = _mm512_add_pd(
+        center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+
+    __m512d dx = _mm512_setzero_pd();
+    __m512d dy = _mm512_setzero_pd();
+    __m512d count = _mm512_setzero_pd();
+    __mmask8 active = 0xff;
+    __mmask8 glitched = 0;
+
+    int n = 0;
+    while (n < limit) {
+      const __m512d ref_x = _mm512_set1_pd(orbit.re[n]);
+      const __m512d ref_y = _mm512_set1_pd(orbit.im[n]);
+      const __m512d zx = _mm512_add_pd(ref_x, dx);
+      const __m512d zy = _mm512_add_pd(ref_y, dy);
+      const __m512d r2 = _mm512_add_pd(_mm512_mul_pd(zx, zx),
+                                       _mm512_mul_pd(zy, zy));
+      active = _mm512_mask_cmp_pd_mask(active, r2, four, _CMP_LT_OQ);
+      const __m512d tolerance = _mm512_set1_pd(
+          kGlitchTolerance*(orbit.re[n]*orbit.re[n] + orbit.im[n]*orbit.im[n]));
+      const __mmask8 glitch =
+          _mm512_mask_cmp_pd_mask(active, r2, tolerance, _CMP_LT_OQ);
+      glitched |= glitch;
+      active &= ~glitch;
+      if (active == 0) {
+        break;
+      }
+
+      if (bla != nullptr) {
+        const __m512d d2 = _mm512_maskz_mov_pd(active, _mm512_add_pd(
+            _mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+        const BlaStep* step = bla->Lookup(n, _mm512_reduce_max_pd(d2), limit);
+        if (step != nullptr) {
+          const __m512d ax = _mm512_set1_pd(step->ax);
+          const __m512d ay = _mm512_set1_pd(step->ay);
+          const __m512d bx = _mm512_set1_pd(step->bx);
+          const __m512d by = _mm512_set1_pd(step->by);
+          const __m512d nx = _mm512_add_pd(
+              _mm512_sub_pd(_mm512_mul_pd(ax, dx), _mm512_mul_pd(ay, dy)),
+              _mm512_sub_pd(_mm512_mul_pd(bx, dcx), _mm512_mul_pd(by, dcy)));
+          dy = _mm512_add_pd(
+              _mm512_add_pd(_mm512_mul_pd(ax, dy), _mm512_mul_pd(ay, dx)),
+              _mm512_add_pd(_mm512_mul_pd(bx, dcy), _mm512_mul_pd(by, dcx)));
+          dx = nx;
+          count = _mm512_mask_add_pd(
+              count, active, count, _mm512_set1_pd(step->length));
+          n += step->length;
+          continue;
+        }
+      }
+
+      count = _mm512_mask_add_pd(count, active, count, one);
+      const __m512d tx = _mm512_add_pd(_mm512_add_pd(ref_x, ref_x), dx);
+      const __m512d ty = _mm512_add_pd(_mm512_add_pd(ref_y, ref_y), dy);
+      const __m512d nx = _mm512_add_pd(
+          _mm512_sub_pd(_mm512_mul_pd(tx, dx), _mm512_mul_pd(ty, dy)), dcx);
+      dy = _mm512_add_pd(
+          _mm512_add_pd(_mm512_mul_pd(tx, dy), _mm512_mul_pd(ty, dx)), dcy);
+      dx = nx;
+      ++n;
+    }
+
+    if (limit < view.max_iter && n >= limit) {
+      glitched |= active;
+    }
+    count = _mm512_mask_sub_pd(
+        count, glitched, _mm512_set1_pd(-1.0), count);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + (x-x0)),
+                        _mm512_cvtpd_epi32(count));
+  }
+
+  if (x < x1) {
+    PerturbationRowScalar(orbit, bla, view, y, x, x1, out + (x-x0));
+  }
+}
+
+
+// Lanes that converge keep their z and step count while the others go on.
+
+__attribute__((target("avx2")))
+void NewtonRowAvx2(const Polynomial& polynomial, const View& view, int y,
+                   int x0, int x1, int* roots, int* steps) {
+  const int n = polynomial.degree();
+  __m256d coeff_x[Polynomial::kMaxDegree + 1];
+  __m256d coeff_y[Polynomial::kMaxDegree + 1];
+  __m256d root_x[Polynomial::kMaxDegree];
+  __m256d root_y[Polynomial::kMaxDegree];
+  for (int k = 0; k <= n; ++k) {
+    coeff_x[k] = _mm256_set1_pd(polynomial.coefficients()[k].real());
+    coeff_y[k] = _mm256_set1_pd(polynomial.coefficients()[k].imag());
+  }
+  for (int i = 0; i < n; ++i) {
+    root_x[i] = _mm256_set1_pd(polynomial.roots()[i].real());
+    root_y[i] = _mm256_set1_pd(polynomial.roots()[i].imag());
+  }
+
+  const double width = view.width();
+  const __m256d center_x = _mm256_set1_pd(view.center.x);
+  const __m256d w = _mm256_set1_pd(width);
+  const __m256d pixel_width = _mm256_set1_pd(view.pixel_width);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d tolerance2 =
+      _mm256_set1_pd(kNewtonTolerance*kNewtonTolerance);
+  const __m256d radius2 = _mm256_set1_pd(kNewtonRootRadius*kNewtonRootRadius);
+  const __m256d start_y = _mm256_set1_pd(PixelY(view, y));
+
+  int x = x0;
+  for (; x + 4 <= x1; x += 4) {
+    __m256d px = _mm256_set_pd(x+3, x+2, x+1, x);
+    px = _mm256_div_pd(_mm256_add_pd(px, half), pixel_width);
+    __m256d zx = _mm256_add_pd(
+        center_x, _mm256_mul_pd(_mm256_sub_pd(px, half), w));
+    __m256d zy = start_y;
+    __m256d root = _mm256_set1_pd(-1.0);
+    __m256d count = _mm256_setzero_pd();
+    __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+    for (int iter = 0; iter < view.max_iter; ++iter) {
+      for (int i = 0; i < n; ++i) {
+        const __m256d ex = _mm256_sub_pd(zx, root_x[i]);
+        const __m256d ey = _mm256_sub_pd(zy, root_y[i]);
+        const __m256d hit = _mm256_and_pd(active, _mm256_cmp_pd(
+            _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey)),
+            tolerance2, _CMP_LT_OQ));
+        root = _mm256_blendv_pd(root, _mm256_set1_pd(i), hit);
+        active = _mm256_andnot_pd(hit, active);
+      }
+      if (_mm256_movemask_pd(active) == 0) {
+        break;
+      }
+
+      __m256d fx = coeff_x[n];
+      __m256d fy = coeff_y[n];
+      __m256d dx = _mm256_setzero_pd();
+      __m256d dy = _mm256_setzero_pd();
+      for (int k = n - 1; k >= 0; --k) {
+        const __m256d ndx = _mm256_add_pd(
+            _mm256_sub_pd(_mm256_mul_pd(dx, zx), _mm256_mul_pd(dy, zy)), fx);
+        dy = _mm256_add_pd(
+            _mm256_add_pd(_mm256_mul_pd(dx, zy), _mm256_mul_pd(dy, zx)), fy);
+        dx = ndx;
+        const __m256d nfx = _mm256_add_pd(
+            _mm256_sub_pd(_mm256_mul_pd(fx, zx), _mm256_mul_pd(fy, zy)),
+            coeff_x[k]);
+        fy = _mm256_add_pd(
+            _mm256_add_pd(_mm256_mul_pd(fx, zy), _mm256_mul_pd(fy, zx)),
+            coeff_y[k]);
+        fx = nfx;
+      }
+      const __m256d d = _mm256_add_pd(_mm256_mul_pd(dx, dx),
+                                      _mm256_mul_pd(dy, dy));
+      const __m256d sx = _mm256_div_pd(
+          _mm256_add_pd(_mm256_mul_pd(fx, dx), _mm256_mul_pd(fy, dy)), d);
+      const __m256d sy = _mm256_div_pd(
+          _mm256_sub_pd(_mm256_mul_pd(fy, dx), _mm256_mul_pd(fx, dy)), d);
+      zx = _mm256_blendv_pd(zx, _mm256_sub_pd(zx, sx), active);
+      zy = _mm256_blendv_pd(zy, _mm256_sub_pd(zy, sy), active);
+      count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+      active = _mm256_andnot_pd(_mm256_cmp_pd(
+          _mm256_add_pd(_mm256_mul_pd(sx, sx), _mm256_mul_pd(sy, sy)),
+          tolerance2, _CMP_LT_OQ), active);
+    }
+
+    // Lanes that stopped without reaching a root's tolerance.
+    __m256d unresolved = _mm256_cmp_pd(root, _mm256_setzero_pd(), _CMP_LT_OQ);
+    for (int i = 0; i < n; ++i) {
+      const __m256d ex = _mm256_sub_pd(zx, root_x[i]);
+      const __m256d ey = _mm256_sub_pd(zy, root_y[i]);
+      const __m256d near = _mm256_and_pd(unresolved, _mm256_cmp_pd(
+          _mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey)),
+          radius2, _CMP_LT_OQ));
+      root = _mm256_blendv_pd(root, _mm256_set1_pd(i), near);
+      unresolved = _mm256_andnot_pd(near, unresolved);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(roots + (x-x0)),
+                     _mm256_cvtpd_epi32(root));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(steps + (x-x0)),
+                     _mm256_cvtpd_epi32(count));
+  }
+
+  if (x < x1) {
+    NewtonRowScalar(polynomial, view, y, x, x1, roots + (x-x0),
+                    steps + (x-x0));
+  }
+}
+
+
+__attribute__((target("avx512f")))
+void NewtonRowAvx512(const Polynomial& polynomial, const View& view, int y,
+                     int x0, int x1, int* roots, int* steps) {
+  const int n = polynomial.degree();
+  __m512d coeff_x[Polynomial::kMaxDegree + 1];
+  __m512d coeff_y[Polynomial::kMaxDegree + 1];
+  __m512d root_x[Polynomial::kMaxDegree];
+  __m512d root_y[Polynomial::kMaxDegree];
+  for (int k = 0; k <= n; ++k) {
+    coeff_x[k] = _mm512_set1_pd(polynomial.coefficients()[k].real());
+    coeff_y[k] = _mm512_set1_pd(polynomial.coefficients()[k].imag());
+  }
+  for (int i = 0; i < n; ++i) {
+    root_x[i] = _mm512_set1_pd(polynomial.roots()[i].real());
+    root_y[i] = _mm512_set1_pd(polynomial.roots()[i].imag());
+  }
+
+  const double width = view.width();
+  const __m512d center_x = _mm512_set1_pd(view.center.x);
+  const __m512d w = _mm512_set1_pd(width);
+  const __m512d pixel_width = _mm512_set1_pd(view.pixel_width);
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d tolerance2 =
+      _mm512_set1_pd(kNewtonTolerance*kNewtonTolerance);
+  const __m512d radius2 = _mm512_set1_pd(kNewtonRootRadius*kNewtonRootRadius);
+  const __m512d start_y = _mm512_set1_pd(PixelY(view, y));
+
+  int x = x0;
+  for (; x + 8 <= x1; x += 8) {
+    __m512d px = _mm512_set_pd(x+7, x+6, x+5, x+4, x+3, x+2, x+1, x);
+    px = _mm512_div_pd(_mm512_add_pd(px, half), pixel_width);
+    __m512d zx = _mm512_add_pd(
+        center_x, _mm512_mul_pd(_mm512_sub_pd(px, half), w));
+    __m512d zy = start_y;
+    __m512d root = _mm512_set1_pd(-1.0);
+    __m512d count = _mm512_setzero_pd();
+    __mmask8 active = 0xff;
+
+    for (int iter = 0; iter < view.max_iter; ++iter) {
+      for (int i = 0; i < n; ++i) {
+        const __m512d ex = _mm512_sub_pd(zx, root_x[i]);
+        const __m512d ey = _mm512_sub_pd(zy, root_y[i]);
+        const __mmask8 hit = _mm512_mask_cmp_pd_mask(
+            active,
+            _mm512_add_pd(_mm512_mul_pd(ex, ex), _mm512_mul_pd(ey, ey)),
+            tolerance2, _CMP_LT_OQ);
+        root = _mm512_mask_mov_pd(root, hit, _mm512_set1_pd(i));
+        active &= ~hit;
+      }
+      if (active == 0) {
+        break;
+      }
+
+      __m512d fx = coeff_x[n];
+      __m512d fy = coeff_y[n];
+      __m512d dx = _mm512_setzero_pd();
+      __m512d dy = _mm512_setzero_pd();
+      for (int k = n - 1; k >= 0; --k) {
+        const __m512d ndx = _mm512_add_pd(
+            _mm512_sub_pd(_mm512_mul_pd(dx, zx), _mm512_mul_pd(dy, zy)), fx);
+        dy = _mm512_add_pd(
+            _mm512_add_pd(_mm512_mul_pd(dx, zy), _mm512_mul_pd(dy, zx)), fy);
+        dx = ndx;
+        const __m512d nfx = _mm512_add_pd(
+            _mm512_sub_pd(_mm512_mul_pd(fx, zx), _mm512_mul_pd(fy, zy)),
+            coeff_x[k]);
+        fy = _mm512_add_pd(
+            _mm512_add_pd(_mm512_mul_pd(fx, zy), _mm512_mul_pd(fy, zx)),
+            coeff_y[k]);
+        fx = nfx;
+      }
+      const __m512d d = _mm512_add_pd(_mm512_mul_pd(dx, dx),
+                                      _mm512_mul_pd(dy, dy));
+      const __m512d sx = _mm512_div_pd(
+          _mm512_add_pd(_mm512_mul_pd(fx, dx), _mm512_mul_pd(fy, dy)), d);
+      const __m512d sy = _mm512_div_pd(
+          _mm512_sub_pd(_mm512_mul_pd(fy, dx), _mm512_mul_pd(fx, dy)), d);
+      zx = _mm512_mask_sub_pd(zx, active, zx, sx);
+      zy = _mm512_mask_sub_pd(zy, active, zy, sy);
+      count = _mm512_mask_add_pd(count, active, count, one);
+      active &= ~_mm512_cmp_pd_mask(
+          _mm512_add_pd(_mm512_mul_pd(sx, sx), _mm512_mul_pd(sy, sy)),
+          tolerance2, _CMP_LT_OQ);
+    }
+
+    // Lanes that stopped without reaching a root's tolerance.
+    __mmask8 unresolved =
+        _mm512_cmp_pd_mask(root, _mm512_setzero_pd(), _CMP_LT_OQ);
+    for (int i = 0; i < n; ++i) {
+      const __m512d ex = _mm512_sub_pd(zx, root_x[i]);
+      const __m512d ey = _mm512_sub_pd(zy, root_y[i]);
+      const __mmask8 near = _mm512_mask_cmp_pd_mask(
+          unresolved,
+          _mm512_add_pd(_mm512_mul_pd(ex, ex), _mm512_mul_pd(ey, ey)),
+          radius2, _CMP_LT_OQ);
+      root = _mm512_mask_mov_pd(root, near, _mm512_set1_pd(i));
+      unresolved &= ~near;
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(roots + (x-x0)),
+                        _mm512_cvtpd_epi32(root));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(steps + (x-x0)),
+                        _mm512_cvtpd_epi32(count));
+  }
+
+  if (x < x1) {
+    NewtonRowScalar(polynomial, view, y, x, x1, roots + (x-x0),
+                    steps + (x-x0));
+  }
+}
+
+#else
+
+namespace {
+
+template <bool kInteriorChecks>
+void MandelbrotRowAvx2Impl(const View& view, int y, int x0, int x1,
+                           int* out) {
+  MandelbrotRowScalarImpl<kInteriorChecks>(view, y, x0, x1, out);
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotRowAvx512Impl(const View& view, int y, int x0, int x1,
+                             int* out) {
+  MandelbrotRowScalarImpl<kInteriorChecks>(view, y, x0, x1, out);
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotPointsAvx2Impl(const View& view, int n, const int* x,
+                              const int* y, int* out) {
+  MandelbrotPointsScalarImpl<kInteriorChecks>(view, n, x, y, out);
+}
+
+
+template <bool kInteriorChecks>
+void MandelbrotPointsAvx512Impl(const View& view, int n, const int* x,
+                                const int* y, int* out) {
+  MandelbrotPointsScalarImpl<kInteriorChecks>(view, n, x, y, out);
+}
+
+}  // namespace
+
+
+void MandelbrotRowAvx2(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotRowScalar(view, y, x0, x1, out);
+}
+
+
+void MandelbrotRowAvx512(const View& view, int y, int x0, int x1, int* out) {
+  MandelbrotRowScalar(view, y, x0, x1, out);
+}
+
+
+void PerturbationRowAvx2(const ReferenceOrbit& orbit, const BlaTable* bla,
+                         const View& view, int y, int x0, int x1, int* out) {
+  PerturbationRowScalar(orbit, bla, view, y, x0, x1, out);
+}
+
+
+void NewtonRowAvx2(const Polynomial& polynomial, const View& view, int y,
+                   int x0, int x1, int* roots, int* steps) {
+  NewtonRowScalar(polynomial, view, y, x0, x1, roots, steps);
+}
+
+
+void NewtonRowAvx512(const Polynomial& polynomial, const View& view, int y,
+                     int x0, int x1, int* roots, int* steps) {
+  NewtonRowScalar(polynomial, view, y, x0, x1, roots, steps);
+}
+
+
+void PerturbationRowAvx512(const ReferenceOrbit& orbit, const BlaTable* bla,
+                           const View& view, int y, int x0, int x1,
+                           int* out) {
+  PerturbationRowScalar(orbit, bla, view, y, x0, x1, out);
+}
+
+#endif
+
+
+MandelbrotRowKernel GetMandelbrotRowKernel(Isa isa, bool interior_checks) {
+  if (interior_checks) {
+    switch (isa) {
+      case Isa::kAvx2: return &MandelbrotRowAvx2Impl<true>;
+      case Isa::kAvx512: return &MandelbrotRowAvx512Impl<true>;
+      default: return &MandelbrotRowScalarImpl<true>;
+    }
+  }
+  switch (isa) {
+    case Isa::kAvx2: return &MandelbrotRowAvx2Impl<false>;
+    case Isa::kAvx512: return &MandelbrotRowAvx512Impl<false>;
+    default: return &MandelbrotRowScalarImpl<false>;
+  }
+}
+
+
+MandelbrotPointsKernel GetMandelbrotPointsKernel(Isa isa,
+                                                 bool interior_checks) {
+  if (interior_checks) {
+    switch (isa) {
+      case Isa::kAvx2: return &MandelbrotPointsAvx2Impl<true>;
+      case Isa::kAvx512: return &MandelbrotPointsAvx512Impl<true>;
+      default: return &MandelbrotPointsScalarImpl<true>;
+    }
+  }
+  switch (isa) {
+    case Isa::kAvx2: return &MandelbrotPointsAvx2Impl<false>;
+    case Isa::kAvx512: return &MandelbrotPointsAvx512Impl<false>;
+    default: return &MandelbrotPointsScalarImpl<false>;
+  }
+}
@@ -1,13 +1,308 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 #include "fractal.hpp"
+#include "offscreen.hpp"
+#include "render_jobs.hpp"
 
 
-int main() {
+namespace {
+
+void PrintUsage() {
+  std::cerr <<
+      "usage: main                       interactive viewer\n"
+      "       main record SESSION        viewer, recording its input\n"
+      "       main replay [--dt S] SESSION\n"
+      "                                  replay the input at S seconds per "
+      "frame\n"
+      "                                  (default 1/60), report frame "
+      "times\n"
+      "       main image [options] OUT   render to OUT (.png or .ppm)\n"
+      "       main render [options] JOBS render a job list (JSON lines or "
+      "CSV)\n"
+      "options:\n"
+      "  --fractal TYPE    mandelbrot, newton or deep (default mandelbrot)\n"
+      "  --center X,Y      center of the image (default 0,0)\n"
+      "  --width W         width of the complex plane shown (default 2)\n"
+      "  --max-iter N      iteration limit (default 500)\n"
+      "  --size WxH        image size in pixels (default 600x600)\n"
+      "  --polynomial P    Newton polynomial, highest power first\n"
+      "                    (default \"1 0 0 -1\" for z^3 - 1)\n"
+      "  --subdivide       skip uniform rectangles of a Mandelbrot image\n"
+      "  --threads N       worker threads (default: all cores)\n"
+      "                    (render takes only --threads and --palette)\n"
+      "  --palette FILE    palette image (default textures/pal0.png)\n";
+}
+
+
+// Renders a single image without opening a window.
+int RunImage(int argc, char** argv) {
+  ImageJob job;
+  std::string output;
+  std::string palette = "textures/pal0.png";
+  int threads = 0;
+
+  for (int i = 0; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      output = arg;
+      continue;
+    }
+    if (arg == "--subdivide") {
+      job.subdivide = true;
+      continue;
+    }
+    if (i + 1 == argc) {
+      std::cerr << "missing value for " << arg << "\n";
+      return 1;
+    }
+    const std::string value = argv[++i];
+    if (arg == "--fractal") {
+      if (!ParseFractalType(value, &job.type)) {
+        std::cerr << "unknown fractal " << value << "\n";
+        return 1;
+      }
+    }
+    else if (arg == "--center") {
+      const auto comma = value.find(',');
+      if (comma == std::string::npos) {
+        std::cerr << "--center expects X,Y\n";
+        return 1;
+      }
+      job.center_x = value.substr(0, comma);
+      job.center_y = value.substr(comma + 1);
+      if (!IsCoordinate(job.center_x) || !IsCoordinate(job.center_y)) {
+        std::cerr << "bad center " << value << "\n";
+        return 1;
+      }
+    }
+    else if (arg == "--width") {
+      job.width = std::atof(value.c_str());
+    }
+    else if (arg == "--max-iter") {
+      job.max_iter = std::atoi(value.c_str());
+    }
+    else if (arg == "--size") {
+      if (std::sscanf(value.c_str(), "%dx%d",
+                      &job.pixel_width, &job.pixel_height) != 2) {
+        std::cerr << "--size expects WxH\n";
+        return 1;
+      }
+    }
+    else if (arg == "--polynomial") {
+      if (!ParsePolynomial(value, &job.polynomial)) {
+        std::cerr << "bad polynomial " << value << " (at most degree "
+                  << Polynomial::kMaxDegree << ")\n";
+        return 1;
+      }
+    }
+    else if (arg == "--threads") {
+      threads = std::atoi(value.c_str());
+    }
+    else if (arg == "--palette") {
+      palette = value;
+    }
+    else {
+      std::cerr << "unknown option " << arg << "\n";
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (output.empty() || job.width <= 0.0 || job.max_iter <= 0 ||
+      job.pixel_width <= 0 || job.pixel_height <= 0) {
+    PrintUsage();
+    return 1;
+  }
+
+  OffscreenRenderer renderer(threads);
+  if (!renderer.LoadPalette(palette)) {
+    std::cerr << "could not load " << palette << ", using a grey ramp\n";
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Image image;
+  renderer.Render(job, image);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (!WriteImage(output, image)) {
+    std::cerr << "could not write " << output << "\n";
+    return 1;
+  }
+  std::cout << output << ": " << image.width << "x" << image.height << " "
+            << FractalTypeName(job.type) << " in " << elapsed.count()
+            << " s\n";
+  return 0;
+}
+
+
+// Renders every job of a list with one OffscreenRenderer. Images are
+// double-buffered so that writing one overlaps with rendering the next.
+int RunRender(int argc, char** argv) {
+  std::string path;
+  std::string palette = "textures/pal0.png";
+  int threads = 0;
+  for (int i = 0; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc) {
+      threads = std::atoi(argv[++i]);
+    }
+    else if (arg == "--palette" && i + 1 < argc) {
+      palette = argv[++i];
+    }
+    else if (arg.rfind("--", 0) != 0 && path.empty()) {
+      path = arg;
+    }
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+  if (path.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "could not open " << path << "\n";
+    return 1;
+  }
+  std::vector<RenderJob> jobs;
+  std::string error;
+  if (!ReadRenderJobs(file, &jobs, &error)) {
+    std::cerr << path << ": " << error << "\n";
+    return 1;
+  }
+
+  OffscreenRenderer renderer(threads);
+  if (!renderer.LoadPalette(palette)) {
+    std::cerr << "could not load " << palette << ", using a grey ramp\n";
+  }
+
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  Image images[2];
+  std::future<bool> pending;
+  const RenderJob* pending_job = nullptr;
+  int failed = 0;
+  long total_pixels = 0;
+  auto finish_write = [&] {
+    if (pending.valid() && !pending.get()) {
+      std::cerr << "could not write " << pending_job->output << "\n";
+      ++failed;
+    }
+  };
+
+  std::printf("%5s %-10s %11s %10s %10s  %s\n",
+              "job", "fractal", "size", "time [ms]", "Mpixel/s", "output");
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const RenderJob& job = jobs[i];
+    Image& image = images[i % 2];
+    const auto t = Clock::now();
+    renderer.Render(job.image, image);
+    const double seconds = std::chrono::duration<double>(
+        Clock::now() - t).count();
+
+    finish_write();
+    pending = std::async(std::launch::async, [&job, &image] {
+      return WriteImage(job.output, image);
+    });
+    pending_job = &job;
+
+    const long pixels = static_cast<long>(image.width)*image.height;
+    total_pixels += pixels;
+    const std::string size = std::to_string(image.width) + "x" +
+                             std::to_string(image.height);
+    std::printf("%5zu %-10s %11s %10.1f %10.2f  %s\n", i,
+                FractalTypeName(job.image.type), size.c_str(), 1e3*seconds,
+                1e-6*pixels/seconds, job.output.c_str());
+  }
+  finish_write();
+
+  const double seconds = std::chrono::duration<double>(
+      Clock::now() - start).count();
+  std::printf("%zu images in %.2f s: %.2f images/s, %.2f Mpixel/s\n",
+              jobs.size(), seconds, jobs.size()/seconds,
+              1e-6*total_pixels/seconds);
+  return failed == 0 ? 0 : 1;
+}
+
+// Replays a session recorded with `main record`.
+int RunReplay(int argc, char** argv) {
+  std::string path;
+  double dt = 1.0/60.0;
+  for (int i = 0; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--dt" && i + 1 < argc) {
+      dt = std::atof(argv[++i]);
+    }
+    else if (arg.rfind("--", 0) != 0 && path.empty()) {
+      path = arg;
+    }
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+  if (path.empty() || dt <= 0.0) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "could not open " << path << "\n";
+    return 1;
+  }
+  std::vector<InputEvent> events;
+  std::string error;
+  if (!ReadSession(file, &events, &error)) {
+    std::cerr << path << ": " << error << "\n";
+    return 1;
+  }
+
   Fractal fractal;
+  fractal.Replay(events, dt);
+  return 0;
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    if (std::strcmp(argv[1], "image") == 0) {
+      return RunImage(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "render") == 0) {
+      return RunRender(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "replay") == 0) {
+      return RunReplay(argc - 2, argv + 2);
+    }
+    if (std::strcmp(argv[1], "record") != 0 || argc != 3) {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  Fractal fractal;
+  if (argc == 3 && !fractal.StartRecording(argv[2])) {
+    std::cerr << "could not write " << argv[2] << "\n";
+    return 1;
+  }
 
   while (!fractal.ShouldClose()) {
     fractal.HandleInput();
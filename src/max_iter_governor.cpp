@@ -0,0 +1,69 @@
+#include "max_iter_governor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+// Samples escaping above this fraction of the limit ask for a higher one.
+constexpr double kNearLimit = 0.5;
+// Largest factor the limit changes by from one frame to the next.
+constexpr double kMaxStep = 2.0;
+// Relative changes below this are not worth a redraw.
+constexpr double kDeadBand = 0.1;
+// Weight of the newest frame in the smoothed iteration cost.
+constexpr double kCostSmoothing = 0.3;
+
+}  // namespace
+
+
+MaxIterGovernor::MaxIterGovernor(double budget) : budget_(budget) {
+}
+
+
+int MaxIterGovernor::Update(const IterationStats& stats, int max_iter,
+                            double seconds, long pixels, long full_pixels) {
+  if (stats.samples == 0 || pixels == 0 || seconds <= 0.0) {
+    return max_iter;
+  }
+  const double saturated =
+      static_cast<double>(stats.saturated)/stats.samples;
+  const double escaped = stats.escaped_sum/stats.samples;
+
+  // Iterations per pixel, counting the saturated ones as running to the end.
+  const double iterations = std::max(1.0, escaped + saturated*max_iter);
+  const double cost = seconds/(pixels*iterations);
+  iteration_cost_ = iteration_cost_ == 0.0
+      ? cost
+      : (1.0 - kCostSmoothing)*iteration_cost_ + kCostSmoothing*cost;
+
+  // Deep views often have nothing escape before the limit at all, which
+  // calls for more iterations just as escapes close to it do.
+  double wanted;
+  if (saturated > 0.0 && (stats.saturated == stats.samples ||
+                          stats.escaped_max > kNearLimit*max_iter)) {
+    wanted = kMaxStep*max_iter;
+  }
+  else if (saturated > 0.0) {
+    wanted = 2.0*stats.escaped_max;
+  }
+  else {
+    // Nothing reached the limit, so it costs nothing where it is.
+    wanted = max_iter;
+  }
+
+  // What the saturated pixels may cost on top of the escaped ones.
+  if (saturated > 0.0) {
+    const double affordable = budget_/(iteration_cost_*full_pixels);
+    wanted = std::min(wanted, (affordable - escaped)/saturated);
+  }
+
+  wanted = std::clamp(wanted, max_iter/kMaxStep, max_iter*kMaxStep);
+  wanted = std::clamp(wanted, static_cast<double>(kMinIter),
+                      static_cast<double>(kMaxIter));
+  if (std::abs(wanted - max_iter) < kDeadBand*max_iter) {
+    return max_iter;
+  }
+  return static_cast<int>(std::lround(wanted));
+}
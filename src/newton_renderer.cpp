@@ -0,0 +1,35 @@
+#include "newton_renderer.hpp"
+
+#include "precision.hpp"
+
+
+NewtonRenderer::NewtonRenderer(int num_threads, Isa isa)
+    : own_scheduler_(std::make_unique<TileScheduler>(num_threads)),
+      scheduler_(own_scheduler_.get()),
+      isa_(IsaSupported(isa) ? isa : Isa::kScalar),
+      kernel_(GetNewtonRowKernel(isa_)),
+      dd_kernel_(GetNewtonDdRowKernel(isa_)) {
+}
+
+
+NewtonRenderer::NewtonRenderer(TileScheduler& scheduler, Isa isa)
+    : scheduler_(&scheduler),
+      isa_(IsaSupported(isa) ? isa : Isa::kScalar),
+      kernel_(GetNewtonRowKernel(isa_)),
+      dd_kernel_(GetNewtonDdRowKernel(isa_)) {
+}
+
+
+void NewtonRenderer::Render(const View& view, IterationBuffer& buffer) {
+  buffer.Resize(view.pixel_width, view.pixel_height);
+  steps_.Resize(view.pixel_width, view.pixel_height);
+
+  const NewtonRowKernel kernel =
+      ChoosePrecision(view) >= Precision::kDoubleDouble ? dd_kernel_ : kernel_;
+  scheduler_->Run(view.pixel_width, view.pixel_height, [&](const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      kernel(polynomial_, view, y, tile.x0, tile.x1, &buffer.at(tile.x0, y),
+             &steps_.at(tile.x0, y));
+    }
+  });
+}
@@ -0,0 +1,144 @@
+#include "offscreen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+
+namespace {
+
+// Root i of n gets the fully saturated hue i/n, so the roots of z^3 - 1 are
+// red, green and blue. Same as in shaders/color.frag.
+Rgb RootColor(int root, int num_roots) {
+  const double h = 6.0*root/num_roots;
+  Rgb rgb;
+  const double offsets[3] = {5.0, 3.0, 1.0};
+  for (int i = 0; i < 3; ++i) {
+    const double k = std::fmod(offsets[i] + h, 6.0);
+    const double v = 1.0 - std::clamp(std::min(k, 4.0 - k), 0.0, 1.0);
+    rgb[i] = static_cast<uint8_t>(std::lround(255*v));
+  }
+  return rgb;
+}
+
+
+}  // namespace
+
+
+bool ParseFractalType(const std::string& name, FractalType* type) {
+  for (auto t : {FractalType::kMandelbrot, FractalType::kNewton,
+                 FractalType::kDeep}) {
+    if (name == FractalTypeName(t)) {
+      *type = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool IsCoordinate(const std::string& s) {
+  char* end;
+  std::strtod(s.c_str(), &end);
+  Fixed unused;
+  return !s.empty() && *end == '\0' && Fixed::Parse(s, 2, &unused);
+}
+
+
+const char* FractalTypeName(FractalType type) {
+  switch (type) {
+    case FractalType::kMandelbrot: return "mandelbrot";
+    case FractalType::kNewton: return "newton";
+    case FractalType::kDeep: return "deep";
+  }
+  return "unknown";
+}
+
+
+View JobView(const ImageJob& job) {
+  View view;
+  view.pixel_width = job.pixel_width;
+  view.pixel_height = job.pixel_height;
+  view.height = job.width/view.aspect_ratio();
+  view.max_iter = job.max_iter;
+  const int limbs = Fixed::LimbsForBits(RequiredPrecision(view) + 64);
+  Fixed::FromString(job.center_x, limbs).ToDoubleDouble(&view.center.x,
+                                                        &view.center_lo.x);
+  Fixed::FromString(job.center_y, limbs).ToDoubleDouble(&view.center.y,
+                                                        &view.center_lo.y);
+  return view;
+}
+
+
+OffscreenRenderer::OffscreenRenderer(int num_threads)
+    : scheduler_(num_threads) {
+}
+
+
+void OffscreenRenderer::Render(const ImageJob& job, Image& image) {
+  View view = JobView(job);
+
+  switch (job.type) {
+    case FractalType::kMandelbrot:
+      if (!mandelbrot_) {
+        mandelbrot_ = std::make_unique<CpuRenderer>(scheduler_);
+      }
+      mandelbrot_->set_subdivision(job.subdivide);
+      mandelbrot_->Render(view, iterations_);
+      break;
+    case FractalType::kNewton:
+      if (!newton_) {
+        newton_ = std::make_unique<NewtonRenderer>(scheduler_);
+      }
+      newton_->set_polynomial(job.polynomial);
+      newton_->Render(view, iterations_);
+      break;
+    case FractalType::kDeep: {
+      if (!deep_) {
+        deep_ = std::make_unique<PerturbationRenderer>(scheduler_);
+      }
+      // The view is centered on the reference.
+      view.center = {0.0, 0.0};
+      view.center_lo = {0.0, 0.0};
+      const int limbs = Fixed::LimbsForBits(RequiredPrecision(view));
+      deep_->set_origin({Fixed::FromString(job.center_x, limbs),
+                         Fixed::FromString(job.center_y, limbs)});
+      deep_->Render(view, iterations_);
+      break;
+    }
+  }
+
+  Colorize(job, image);
+}
+
+
+void OffscreenRenderer::Colorize(const ImageJob& job, Image& image) const {
+  image.Resize(job.pixel_width, job.pixel_height);
+
+  for (int y = 0; y < image.height; ++y) {
+    // IterationBuffer rows run bottom to top.
+    const int row = image.height - 1 - y;
+    for (int x = 0; x < image.width; ++x) {
+      const int n = iterations_.at(x, row);
+      Rgb rgb;
+      if (job.type == FractalType::kNewton) {
+        // Darker the more steps the pixel needed, as in shaders/color.frag.
+        rgb = n >= 0 ? RootColor(n, job.polynomial.degree())
+                     : Rgb{255, 255, 255};
+        const double shade =
+            0.25 + 0.75*std::exp(-0.1*newton_->steps().at(x, row));
+        for (auto& channel : rgb) {
+          channel = static_cast<uint8_t>(channel*shade);
+        }
+      }
+      else {
+        rgb = palette_.Sample(n/static_cast<float>(job.max_iter));
+      }
+      uint8_t* p = image.at(x, y);
+      p[0] = rgb[0];
+      p[1] = rgb[1];
+      p[2] = rgb[2];
+      p[3] = 255;
+    }
+  }
+}
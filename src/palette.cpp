@@ -0,0 +1,41 @@
+#include "palette.hpp"
+
+#include <cmath>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+
+Palette::Palette() : colors_{{0, 0, 0}, {255, 255, 255}} {
+}
+
+
+bool Palette::Load(const std::string& path) {
+  int width, height, nchannels;
+  unsigned char* data = stbi_load(path.c_str(), &width, &height, &nchannels, 3);
+  if (data == nullptr) {
+    return false;
+  }
+  colors_.resize(width);
+  for (int i = 0; i < width; ++i) {
+    colors_[i] = {data[3*i], data[3*i + 1], data[3*i + 2]};
+  }
+  stbi_image_free(data);
+  return true;
+}
+
+
+Rgb Palette::Sample(double t) const {
+  const int n = static_cast<int>(colors_.size());
+  const double u = t*n - 0.5;
+  const double fl = std::floor(u);
+  const double a = u - fl;
+  const int i0 = ((static_cast<int>(fl) % n) + n) % n;
+  const int i1 = (i0 + 1) % n;
+  Rgb rgb;
+  for (int c = 0; c < 3; ++c) {
+    rgb[c] = static_cast<uint8_t>(
+        std::lround((1.0 - a)*colors_[i0][c] + a*colors_[i1][c]));
+  }
+  return rgb;
+}
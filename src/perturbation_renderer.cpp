@@ -0,0 +1,195 @@
+#include "perturbation_renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+namespace {
+
+// Offset of pixel (x, y) from the origin, as computed by the kernels.
+glm::dvec2 PixelOffset(const View& view, int x, int y) {
+  return {view.center.x + ((x + 0.5)/view.pixel_width - 0.5)*view.width(),
+          view.center.y + ((y + 0.5)/view.pixel_height - 0.5)*view.height};
+}
+
+
+// The buffer indices of the largest 4-connected region of glitched pixels.
+std::vector<int> LargestGlitch(const IterationBuffer& buffer) {
+  std::vector<int> largest;
+  std::vector<bool> seen(buffer.data.size(), false);
+  std::vector<int> stack;
+  for (size_t start = 0; start < buffer.data.size(); ++start) {
+    if (seen[start] || buffer.data[start] >= 0) {
+      continue;
+    }
+    std::vector<int> region;
+    seen[start] = true;
+    stack.push_back(static_cast<int>(start));
+    while (!stack.empty()) {
+      const int i = stack.back();
+      stack.pop_back();
+      region.push_back(i);
+      const int x = i % buffer.width;
+      const int y = i / buffer.width;
+      const int neighbours[4][2] = {{x-1, y}, {x+1, y}, {x, y-1}, {x, y+1}};
+      for (const auto& n : neighbours) {
+        if (n[0] < 0 || n[0] >= buffer.width ||
+            n[1] < 0 || n[1] >= buffer.height) {
+          continue;
+        }
+        const int j = n[1]*buffer.width + n[0];
+        if (!seen[j] && buffer.data[j] < 0) {
+          seen[j] = true;
+          stack.push_back(j);
+        }
+      }
+    }
+    if (region.size() > largest.size()) {
+      largest = std::move(region);
+    }
+  }
+  return largest;
+}
+
+
+// The pixel of `region` closest to its centroid. Unlike the centroid
+// itself it is guaranteed to lie inside the region.
+int CentralPixel(const std::vector<int>& region, int width) {
+  double sx = 0.0;
+  double sy = 0.0;
+  for (int i : region) {
+    sx += i % width;
+    sy += i / width;
+  }
+  const double cx = sx/region.size();
+  const double cy = sy/region.size();
+  int best = region.front();
+  double best_d2 = INFINITY;
+  for (int i : region) {
+    const double dx = i % width - cx;
+    const double dy = i / width - cy;
+    if (dx*dx + dy*dy < best_d2) {
+      best_d2 = dx*dx + dy*dy;
+      best = i;
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+
+PerturbationRenderer::PerturbationRenderer(int num_threads, Isa isa)
+    : own_scheduler_(std::make_unique<TileScheduler>(num_threads)),
+      scheduler_(own_scheduler_.get()),
+      kernel_(GetPerturbationRowKernel(IsaSupported(isa) ? isa
+                                                         : Isa::kScalar)) {
+}
+
+
+PerturbationRenderer::PerturbationRenderer(TileScheduler& scheduler, Isa isa)
+    : scheduler_(&scheduler),
+      kernel_(GetPerturbationRowKernel(IsaSupported(isa) ? isa
+                                                         : Isa::kScalar)) {
+}
+
+
+void PerturbationRenderer::Render(const View& view, IterationBuffer& buffer) {
+  buffer.Resize(view.pixel_width, view.pixel_height);
+  orbit_.Update(origin_, view);
+
+  // The merged radii depend on the largest pixel offset, so the table is
+  // rebuilt for every view. That is linear in the orbit length and cheap
+  // next to the render itself.
+  const BlaTable* bla = nullptr;
+  if (use_bla_) {
+    const double max_dc = glm::length(view.center) +
+        0.5*std::hypot(view.width(), view.height);
+    bla_.Build(orbit_, max_dc);
+    bla = &bla_;
+  }
+
+  scheduler_->Run(view.pixel_width, view.pixel_height, [&](const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      kernel_(orbit_, bla, view, y, tile.x0, tile.x1,
+              &buffer.at(tile.x0, y));
+    }
+  });
+
+  glitch_stats_ = {};
+  glitch_stats_.glitched_pixels =
+      std::count_if(buffer.data.begin(), buffer.data.end(),
+                    [](int n) { return n < 0; });
+  if (correct_glitches_ && glitch_stats_.glitched_pixels > 0) {
+    CorrectGlitches(view, buffer);
+  }
+
+  for (int& n : buffer.data) {
+    if (n < 0) {
+      n = -1 - n;
+      ++glitch_stats_.unresolved_pixels;
+    }
+  }
+}
+
+
+void PerturbationRenderer::CorrectGlitches(const View& view,
+                                           IterationBuffer& buffer) {
+  const int frac_limbs = Fixed::LimbsForBits(orbit_.precision);
+  ReferenceOrbit orbit;
+  BlaTable bla;
+
+  // Each reference is placed in the largest glitched region but tried on
+  // every glitched pixel, which clears scattered single-pixel glitches in
+  // bulk. Regions are searched again afterwards since a reference that
+  // escapes early only fixes part of its region. The reference pixel itself
+  // never glitches, so each step makes progress; the budget only bounds the
+  // time spent on pathological views.
+  std::vector<int> pixels;
+  while (glitch_stats_.references < kMaxReferences) {
+    const auto region = LargestGlitch(buffer);
+    if (region.empty()) {
+      break;
+    }
+    ++glitch_stats_.references;
+
+    const int ref = CentralPixel(region, buffer.width);
+    const glm::dvec2 ref_offset =
+        PixelOffset(view, ref % buffer.width, ref / buffer.width);
+    BigComplex c = origin_;
+    c.x += Fixed(ref_offset.x, frac_limbs);
+    c.y += Fixed(ref_offset.y, frac_limbs);
+    orbit.Compute(c, orbit_.precision, view.max_iter);
+
+    pixels.clear();
+    for (size_t i = 0; i < buffer.data.size(); ++i) {
+      if (buffer.data[i] < 0) {
+        pixels.push_back(static_cast<int>(i));
+      }
+    }
+    std::vector<glm::dvec2> dc(pixels.size());
+    double max_dc = 0.0;
+    for (size_t k = 0; k < pixels.size(); ++k) {
+      const int i = pixels[k];
+      dc[k] = PixelOffset(view, i % buffer.width, i / buffer.width) -
+              ref_offset;
+      max_dc = std::max(max_dc, glm::length(dc[k]));
+    }
+    const BlaTable* table = nullptr;
+    if (use_bla_) {
+      bla.Build(orbit, max_dc);
+      table = &bla;
+    }
+
+    const int count = static_cast<int>(pixels.size());
+    scheduler_->Run(count, 1, [&](const Tile& tile) {
+      for (int k = tile.x0; k < tile.x1; ++k) {
+        buffer.data[pixels[k]] = PerturbationPixel(orbit, table, dc[k].x,
+                                                   dc[k].y, view.max_iter);
+      }
+    });
+  }
+}
@@ -0,0 +1,193 @@
+#include "polynomial.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+
+namespace {
+
+using Complex = std::complex<double>;
+
+
+double Argument(Complex z) {
+  const double a = std::arg(z);
+  return a < 0.0 ? a + 2.0*M_PI : a;
+}
+
+
+bool ParseReal(const std::string& s, double* value) {
+  char* end;
+  *value = std::strtod(s.c_str(), &end);
+  return !s.empty() && *end == '\0';
+}
+
+
+bool ParseCoefficient(const std::string& s, Complex* c) {
+  if (s.back() != 'i') {
+    double re;
+    if (!ParseReal(s, &re)) {
+      return false;
+    }
+    *c = re;
+    return true;
+  }
+
+  // The imaginary part starts at the last sign that is not an exponent's.
+  const std::string body = s.substr(0, s.size() - 1);
+  size_t split = 0;
+  for (size_t i = 1; i < body.size(); ++i) {
+    if ((body[i] == '+' || body[i] == '-') &&
+        body[i-1] != 'e' && body[i-1] != 'E') {
+      split = i;
+    }
+  }
+  double re = 0.0;
+  if (split > 0 && !ParseReal(body.substr(0, split), &re)) {
+    return false;
+  }
+  const std::string im_text = body.substr(split);
+  double im;
+  if (im_text.empty() || im_text == "+") {
+    im = 1.0;
+  }
+  else if (im_text == "-") {
+    im = -1.0;
+  }
+  else if (!ParseReal(im_text, &im)) {
+    return false;
+  }
+  *c = {re, im};
+  return true;
+}
+
+}  // namespace
+
+
+Polynomial::Polynomial(std::vector<std::complex<double>> coefficients)
+    : coefficients_(std::move(coefficients)) {
+  while (coefficients_.size() > 1 && coefficients_.back() == 0.0) {
+    coefficients_.pop_back();
+  }
+  FindRoots();
+}
+
+
+Polynomial Polynomial::UnitRoots(int degree) {
+  std::vector<Complex> coefficients(degree + 1);
+  coefficients[0] = -1.0;
+  coefficients[degree] = 1.0;
+  return Polynomial(std::move(coefficients));
+}
+
+
+void Polynomial::Evaluate(Complex z, Complex* f, Complex* df) const {
+  Complex p = coefficients_.back();
+  Complex dp = 0.0;
+  for (int k = degree() - 1; k >= 0; --k) {
+    dp = dp*z + p;
+    p = p*z + coefficients_[k];
+  }
+  *f = p;
+  *df = dp;
+}
+
+
+// Durand-Kerner: every root estimate takes a Newton-like step on the monic
+// polynomial divided by its distances to all other estimates, so the
+// estimates repel each other instead of converging to the same root.
+void Polynomial::FindRoots() {
+  const int n = degree();
+  roots_.assign(n, 0.0);
+  if (n < 1) {
+    return;
+  }
+
+  const Complex lead = coefficients_.back();
+  auto monic = [&](Complex z) {
+    Complex p = 1.0;
+    for (int k = n - 1; k >= 0; --k) {
+      p = p*z + coefficients_[k]/lead;
+    }
+    return p;
+  };
+
+  // The usual starting points, powers of a number that is neither real nor
+  // a root of unity.
+  Complex start = 1.0;
+  for (auto& root : roots_) {
+    root = start;
+    start *= Complex(0.4, 0.9);
+  }
+
+  for (int iter = 0; iter < 1000; ++iter) {
+    double change = 0.0;
+    double size = 1.0;
+    for (int i = 0; i < n; ++i) {
+      Complex denominator = 1.0;
+      for (int j = 0; j < n; ++j) {
+        if (j != i) {
+          denominator *= roots_[i] - roots_[j];
+        }
+      }
+      const Complex delta = monic(roots_[i])/denominator;
+      roots_[i] -= delta;
+      change = std::max(change, std::abs(delta));
+      size = std::max(size, std::abs(roots_[i]));
+    }
+    if (change < 1e-15*size) {
+      break;
+    }
+  }
+
+  // Polish with plain Newton, and clean up parts that are zero up to
+  // rounding so that the argument order doesn't depend on their sign.
+  for (auto& root : roots_) {
+    for (int i = 0; i < 3; ++i) {
+      Complex f, df;
+      Evaluate(root, &f, &df);
+      if (df != 0.0) {
+        root -= f/df;
+      }
+    }
+    const double tiny = 1e-12*std::max(1.0, std::abs(root));
+    root = {std::abs(root.real()) < tiny ? 0.0 : root.real(),
+            std::abs(root.imag()) < tiny ? 0.0 : root.imag()};
+  }
+  std::sort(roots_.begin(), roots_.end(), [](Complex a, Complex b) {
+    return Argument(a) < Argument(b);
+  });
+}
+
+
+bool ParsePolynomial(const std::string& text, Polynomial* polynomial) {
+  std::vector<Complex> coefficients;
+  size_t i = 0;
+  while (i < text.size()) {
+    const size_t end = text.find_first_of(", \t", i);
+    const std::string token = text.substr(i, end - i);
+    if (!token.empty()) {
+      Complex c;
+      if (!ParseCoefficient(token, &c)) {
+        return false;
+      }
+      coefficients.push_back(c);
+    }
+    if (end == std::string::npos) {
+      break;
+    }
+    i = end + 1;
+  }
+
+  if (coefficients.empty()) {
+    return false;
+  }
+  std::reverse(coefficients.begin(), coefficients.end());
+  Polynomial result(std::move(coefficients));
+  if (result.degree() < 1 || result.degree() > Polynomial::kMaxDegree) {
+    return false;
+  }
+  *polynomial = std::move(result);
+  return true;
+}
@@ -0,0 +1,47 @@
+#include "polynomial_buffer.hpp"
+
+#include <cstdint>
+
+#include <glad/glad.h>
+
+
+namespace {
+
+// std140 layout of the Polynomial block.
+struct PolynomialBlock {
+  double coefficients[Polynomial::kMaxDegree + 1][2];
+  double roots[Polynomial::kMaxDegree][2];
+  int32_t degree;
+};
+
+}  // namespace
+
+
+PolynomialBuffer::PolynomialBuffer() {
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(PolynomialBlock), nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, kBinding, buffer_);
+}
+
+
+PolynomialBuffer::~PolynomialBuffer() {
+  glDeleteBuffers(1, &buffer_);
+}
+
+
+void PolynomialBuffer::Upload(const Polynomial& polynomial) const {
+  PolynomialBlock block = {};
+  for (int k = 0; k <= polynomial.degree(); ++k) {
+    block.coefficients[k][0] = polynomial.coefficients()[k].real();
+    block.coefficients[k][1] = polynomial.coefficients()[k].imag();
+  }
+  for (int i = 0; i < polynomial.degree(); ++i) {
+    block.roots[i][0] = polynomial.roots()[i].real();
+    block.roots[i][1] = polynomial.roots()[i].imag();
+  }
+  block.degree = polynomial.degree();
+  glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+}
@@ -0,0 +1,72 @@
+#include "precision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+// Two floats carry 48 bits, less a few for the Dekker product and the
+// renormalisations.
+constexpr double kDoubleFloatEpsilon = 0x1p-44;
+
+// Double-double carries about 106 bits, of which the last couple are lost
+// to the renormalisation in every operation.
+constexpr double kDoubleDoubleEpsilon = 0x1p-104;
+
+}  // namespace
+
+
+const char* PrecisionName(Precision precision) {
+  switch (precision) {
+    case Precision::kFloat:
+      return "float";
+    case Precision::kDoubleFloat:
+      return "double-float";
+    case Precision::kDouble:
+      return "double";
+    case Precision::kDoubleDouble:
+      return "double-double";
+    case Precision::kPerturbation:
+      return "perturbation";
+  }
+  return "unknown";
+}
+
+
+Precision ChoosePrecision(const View& view, bool double_float) {
+  const double scale =
+      std::max({1.0, std::abs(view.center.x), std::abs(view.center.y)});
+  const double ulps = view.height/view.pixel_height/scale/kUlpsPerPixel;
+  // Float and double-float lose about a bit more of the pixel spacing with
+  // every doubling of max_iter, enough to change a few percent of the
+  // counts near the boundary by 1000 iterations; `fractal_bench precision`
+  // measures it. Double and double-double keep far more bits than a pixel
+  // needs at the widths they are picked for.
+  const double iterated_ulps = ulps/std::max(1, view.max_iter);
+  if (iterated_ulps >= std::numeric_limits<float>::epsilon()) {
+    return Precision::kFloat;
+  }
+  if (double_float && iterated_ulps >= kDoubleFloatEpsilon) {
+    return Precision::kDoubleFloat;
+  }
+  if (ulps >= std::numeric_limits<double>::epsilon()) {
+    return Precision::kDouble;
+  }
+  if (ulps >= kDoubleDoubleEpsilon) {
+    return Precision::kDoubleDouble;
+  }
+  return Precision::kPerturbation;
+}
+
+
+void SplitToFloats(glm::dvec2 v, glm::vec2* hi, glm::vec2* lo) {
+  // One component at a time and through memory: GCC 12 vectorizes the
+  // pair and then folds double(float(x)) back into x, leaving lo zero.
+  for (int i = 0; i < 2; ++i) {
+    const volatile float h = static_cast<float>(v[i]);
+    (*hi)[i] = h;
+    (*lo)[i] = static_cast<float>(v[i] - h);
+  }
+}
@@ -0,0 +1,168 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace {
+
+constexpr double kReportInterval = 1.0;
+
+}  // namespace
+
+
+void RollingStats::Add(double seconds) {
+  samples_[next_] = seconds;
+  next_ = (next_ + 1) % kWindow;
+  count_ = std::min(count_ + 1, kWindow);
+}
+
+
+double RollingStats::Mean() const {
+  double sum = 0.0;
+  for (int i = 0; i < count_; ++i) {
+    sum += samples_[i];
+  }
+  return count_ > 0 ? sum/count_ : 0.0;
+}
+
+
+double RollingStats::Percentile(double p) const {
+  if (count_ == 0) {
+    return 0.0;
+  }
+  std::vector<double> sorted(samples_.begin(), samples_.begin() + count_);
+  const int rank = std::clamp(static_cast<int>(p*count_), 0, count_ - 1);
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  return sorted[rank];
+}
+
+
+void Profiler::set_enabled(bool enabled) {
+  enabled_ = enabled;
+  if (!enabled) {
+    for (Pass& pass : passes_) {
+      pass.stats.Clear();
+    }
+  }
+}
+
+
+void Profiler::BeginGpu(const std::string& name) {
+  if (!enabled_) {
+    return;
+  }
+  Pass& pass = Find(name, true);
+  if (!pass.timer) {
+    pass.timer = std::make_unique<GpuTimer>();
+  }
+  pass.timer->Begin();
+}
+
+
+void Profiler::EndGpu(const std::string& name) {
+  if (!enabled_) {
+    return;
+  }
+  Pass& pass = Find(name, true);
+  if (pass.timer) {
+    pass.timer->End();
+  }
+}
+
+
+void Profiler::AddGpuSample(const std::string& name, double seconds) {
+  if (enabled_) {
+    Find(name, true).stats.Add(seconds);
+  }
+}
+
+
+void Profiler::AddCpuSample(const std::string& name, double seconds) {
+  if (enabled_) {
+    Find(name, false).stats.Add(seconds);
+  }
+}
+
+
+bool Profiler::EndFrame(double now) {
+  // Timers keep their queries after the profiler is disabled, so drain them
+  // either way.
+  for (Pass& pass : passes_) {
+    double seconds;
+    while (pass.timer && pass.timer->Poll(&seconds)) {
+      if (enabled_) {
+        pass.stats.Add(seconds);
+      }
+    }
+  }
+  if (!enabled_ || now - last_report_ < kReportInterval) {
+    return false;
+  }
+  last_report_ = now;
+  return true;
+}
+
+
+std::string Profiler::Summary() const {
+  std::string summary;
+  char buffer[64];
+  for (const Pass& pass : passes_) {
+    if (pass.stats.count() == 0) {
+      continue;
+    }
+    std::snprintf(buffer, sizeof(buffer), "%s%s %.1f ms",
+                  summary.empty() ? "" : " | ", pass.name.c_str(),
+                  1e3*pass.stats.Mean());
+    summary += buffer;
+  }
+  return summary;
+}
+
+
+void Profiler::PrintReport(std::ostream& out) const {
+  char line[128];
+  std::snprintf(line, sizeof(line), "%-12s %4s %7s %9s %9s %9s %9s %9s\n",
+                "pass", "", "samples", "mean [ms]", "p50", "p90", "p99",
+                "max");
+  out << line;
+  for (const Pass& pass : passes_) {
+    const RollingStats& s = pass.stats;
+    if (s.count() == 0) {
+      continue;
+    }
+    std::snprintf(line, sizeof(line),
+                  "%-12s %4s %7d %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                  pass.name.c_str(), pass.gpu ? "gpu" : "cpu", s.count(),
+                  1e3*s.Mean(), 1e3*s.Percentile(0.5), 1e3*s.Percentile(0.9),
+                  1e3*s.Percentile(0.99), 1e3*s.Percentile(1.0));
+    out << line;
+  }
+  out.flush();
+}
+
+
+Profiler::Pass& Profiler::Find(const std::string& name, bool gpu) {
+  for (Pass& pass : passes_) {
+    if (pass.name == name && pass.gpu == gpu) {
+      return pass;
+    }
+  }
+  passes_.push_back({name, gpu, nullptr, {}});
+  return passes_.back();
+}
+
+
+ScopedTimer::ScopedTimer(Profiler& profiler, const char* pass)
+    : profiler_(profiler.enabled() ? &profiler : nullptr),
+      pass_(pass),
+      start_(std::chrono::steady_clock::now()) {
+}
+
+
+ScopedTimer::~ScopedTimer() {
+  if (profiler_ != nullptr) {
+    profiler_->AddCpuSample(pass_, std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_).count());
+  }
+}
@@ -0,0 +1,117 @@
+#include "reference_orbit.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef FRACTAL_HAVE_GMP
+#include <gmp.h>
+#endif
+
+
+void ReferenceOrbit::Compute(const BigComplex& c, int precision,
+                             int max_iter) {
+  this->c = c;
+  this->precision = precision;
+  this->max_iter = max_iter;
+  escaped = false;
+  re.clear();
+  im.clear();
+
+  if (use_gmp && kHaveGmp) {
+    ComputeGmp(c);
+  }
+  else {
+    ComputeFixed(c);
+  }
+}
+
+
+// Uses three squarings per step instead of two squarings and a product:
+// 2xy = (x + y)^2 - x^2 - y^2.
+void ReferenceOrbit::ComputeFixed(const BigComplex& c) {
+  const int limbs = Fixed::LimbsForBits(precision);
+  BigComplex cc = c;
+  cc.SetPrecision(limbs);
+  Fixed x(0.0, limbs);
+  Fixed y(0.0, limbs);
+
+  for (int n = 0; n <= max_iter; ++n) {
+    const double zx = x.ToDouble();
+    const double zy = y.ToDouble();
+    re.push_back(zx);
+    im.push_back(zy);
+    if (zx*zx + zy*zy >= 4.0) {
+      escaped = true;
+      break;
+    }
+    const Fixed x2 = Square(x);
+    const Fixed y2 = Square(y);
+    y = Square(x + y) - x2 - y2 + cc.y;
+    x = x2 - y2 + cc.x;
+  }
+}
+
+
+#ifdef FRACTAL_HAVE_GMP
+
+void ReferenceOrbit::ComputeGmp(const BigComplex& c) {
+  mpf_t x, y, x2, y2, t, cx, cy;
+  for (auto* v : {&x, &y, &x2, &y2, &t, &cx, &cy}) {
+    mpf_init2(*v, precision);
+  }
+  // Decimal digits carry a little more than precision*log10(2) bits.
+  const int digits = precision*3/10 + 10;
+  mpf_set_str(cx, c.x.ToString(digits).c_str(), 10);
+  mpf_set_str(cy, c.y.ToString(digits).c_str(), 10);
+
+  for (int n = 0; n <= max_iter; ++n) {
+    const double zx = mpf_get_d(x);
+    const double zy = mpf_get_d(y);
+    re.push_back(zx);
+    im.push_back(zy);
+    if (zx*zx + zy*zy >= 4.0) {
+      escaped = true;
+      break;
+    }
+    mpf_mul(x2, x, x);
+    mpf_mul(y2, y, y);
+    mpf_add(t, x, y);
+    mpf_mul(t, t, t);
+    mpf_sub(t, t, x2);
+    mpf_sub(t, t, y2);
+    mpf_add(y, t, cy);
+    mpf_sub(t, x2, y2);
+    mpf_add(x, t, cx);
+  }
+
+  for (auto* v : {&x, &y, &x2, &y2, &t, &cx, &cy}) {
+    mpf_clear(*v);
+  }
+}
+
+#else
+
+void ReferenceOrbit::ComputeGmp(const BigComplex& c) {
+  ComputeFixed(c);
+}
+
+#endif
+
+
+bool ReferenceOrbit::Update(const BigComplex& c, const View& view) {
+  const int required = RequiredPrecision(view);
+  if (c == this->c && precision >= required &&
+      (escaped || max_iter >= view.max_iter)) {
+    return false;
+  }
+  // Leave some headroom so that a slow zoom or a growing max_iter does not
+  // trigger a recomputation every frame.
+  Compute(c, required + 64, view.max_iter + view.max_iter/4);
+  return true;
+}
+
+
+int RequiredPrecision(const View& view) {
+  const double spacing = view.height/view.pixel_height;
+  return std::max(64, static_cast<int>(std::ceil(-std::log2(spacing))) + 32);
+}
@@ -0,0 +1,245 @@
+#include "render_jobs.hpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <utility>
+
+
+namespace {
+
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+
+std::string Trim(const std::string& s) {
+  size_t begin = 0;
+  size_t end = s.size();
+  while (begin < end && std::isspace(static_cast<unsigned char>(s[begin]))) {
+    ++begin;
+  }
+  while (end > begin && std::isspace(static_cast<unsigned char>(s[end-1]))) {
+    --end;
+  }
+  return s.substr(begin, end - begin);
+}
+
+
+bool ParseInt(const std::string& s, int* value) {
+  char* end;
+  const long v = std::strtol(s.c_str(), &end, 10);
+  if (s.empty() || *end != '\0') {
+    return false;
+  }
+  *value = static_cast<int>(v);
+  return true;
+}
+
+
+bool ParseDouble(const std::string& s, double* value) {
+  char* end;
+  const double v = std::strtod(s.c_str(), &end);
+  if (s.empty() || *end != '\0') {
+    return false;
+  }
+  *value = v;
+  return true;
+}
+
+
+bool SetField(RenderJob* job, const std::string& key,
+              const std::string& value, std::string* error) {
+  ImageJob& image = job->image;
+  bool ok = true;
+  if (key == "fractal") {
+    ok = ParseFractalType(value, &image.type);
+  }
+  else if (key == "x" || key == "y") {
+    // Kept as text for the deep backend; checked as a number all the same.
+    ok = IsCoordinate(value);
+    (key == "x" ? image.center_x : image.center_y) = value;
+  }
+  else if (key == "width") {
+    ok = ParseDouble(value, &image.width) && image.width > 0.0;
+  }
+  else if (key == "max_iter") {
+    ok = ParseInt(value, &image.max_iter) && image.max_iter > 0;
+  }
+  else if (key == "pixel_width") {
+    ok = ParseInt(value, &image.pixel_width) && image.pixel_width > 0;
+  }
+  else if (key == "pixel_height") {
+    ok = ParseInt(value, &image.pixel_height) && image.pixel_height > 0;
+  }
+  else if (key == "polynomial") {
+    ok = ParsePolynomial(value, &image.polynomial);
+  }
+  else if (key == "subdivide") {
+    int subdivide;
+    ok = ParseInt(value, &subdivide) && (subdivide == 0 || subdivide == 1);
+    image.subdivide = subdivide == 1;
+  }
+  else if (key == "output") {
+    job->output = value;
+  }
+  else {
+    *error = "unknown key " + key;
+    return false;
+  }
+  if (!ok) {
+    *error = "bad value " + value + " for " + key;
+  }
+  return ok;
+}
+
+
+// A flat object of string and number values, e.g.
+// {"fractal": "deep", "x": "-1.75", "width": 1e-20, "output": "a.png"}.
+// Numbers are kept as written.
+bool ParseJsonObject(const std::string& line, Fields* fields,
+                     std::string* error) {
+  size_t i = 0;
+  auto skip_space = [&] {
+    while (i < line.size() &&
+           std::isspace(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+  };
+  auto read_string = [&](std::string* s) {
+    if (i == line.size() || line[i] != '"') {
+      return false;
+    }
+    for (++i; i < line.size() && line[i] != '"'; ++i) {
+      if (line[i] == '\\' && i + 1 < line.size()) {
+        ++i;
+      }
+      s->push_back(line[i]);
+    }
+    if (i == line.size()) {
+      return false;
+    }
+    ++i;
+    return true;
+  };
+
+  skip_space();
+  if (i == line.size() || line[i++] != '{') {
+    *error = "expected {";
+    return false;
+  }
+  skip_space();
+  if (i < line.size() && line[i] == '}') {
+    return true;
+  }
+  while (true) {
+    std::string key;
+    std::string value;
+    skip_space();
+    if (!read_string(&key)) {
+      *error = "expected a quoted key";
+      return false;
+    }
+    skip_space();
+    if (i == line.size() || line[i++] != ':') {
+      *error = "expected : after " + key;
+      return false;
+    }
+    skip_space();
+    if (i < line.size() && line[i] == '"') {
+      if (!read_string(&value)) {
+        *error = "unterminated string";
+        return false;
+      }
+    }
+    else {
+      while (i < line.size() && line[i] != ',' && line[i] != '}') {
+        value.push_back(line[i++]);
+      }
+      value = Trim(value);
+    }
+    fields->emplace_back(key, value);
+    skip_space();
+    if (i < line.size() && line[i] == ',') {
+      ++i;
+      continue;
+    }
+    if (i < line.size() && line[i] == '}') {
+      return true;
+    }
+    *error = "expected , or }";
+    return false;
+  }
+}
+
+
+std::vector<std::string> SplitCsv(const std::string& line) {
+  std::vector<std::string> cells;
+  size_t begin = 0;
+  while (true) {
+    const size_t comma = line.find(',', begin);
+    cells.push_back(Trim(line.substr(begin, comma - begin)));
+    if (comma == std::string::npos) {
+      return cells;
+    }
+    begin = comma + 1;
+  }
+}
+
+}  // namespace
+
+
+bool ReadRenderJobs(std::istream& in, std::vector<RenderJob>* jobs,
+                    std::string* error) {
+  std::vector<std::string> header;
+  bool json = false;
+  std::string line;
+  for (int line_number = 1; std::getline(in, line); ++line_number) {
+    line = Trim(line);
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    Fields fields;
+    std::string message;
+    if (header.empty() && !json) {
+      if (line[0] == '{') {
+        json = true;
+      }
+      else {
+        header = SplitCsv(line);
+        continue;
+      }
+    }
+    if (json) {
+      if (!ParseJsonObject(line, &fields, &message)) {
+        *error = "line " + std::to_string(line_number) + ": " + message;
+        return false;
+      }
+    }
+    else {
+      const auto cells = SplitCsv(line);
+      if (cells.size() != header.size()) {
+        *error = "line " + std::to_string(line_number) + ": expected " +
+                 std::to_string(header.size()) + " columns";
+        return false;
+      }
+      for (size_t c = 0; c < cells.size(); ++c) {
+        if (!cells[c].empty()) {
+          fields.emplace_back(header[c], cells[c]);
+        }
+      }
+    }
+
+    RenderJob job;
+    for (const auto& [key, value] : fields) {
+      if (!SetField(&job, key, value, &message)) {
+        *error = "line " + std::to_string(line_number) + ": " + message;
+        return false;
+      }
+    }
+    if (job.output.empty()) {
+      *error = "line " + std::to_string(line_number) + ": no output";
+      return false;
+    }
+    jobs->push_back(std::move(job));
+  }
+  return true;
+}
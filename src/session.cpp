@@ -0,0 +1,98 @@
+#include "session.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+
+namespace {
+
+struct EventFormat {
+  InputEvent::Type type;
+  const char* name;
+  int doubles;  // x and y
+  int ints;     // args
+};
+
+constexpr EventFormat kFormats[] = {
+  {InputEvent::Type::kCursorPos, "cursor", 2, 0},
+  {InputEvent::Type::kMouseButton, "button", 0, 3},
+  {InputEvent::Type::kWindowSize, "size", 0, 2},
+  {InputEvent::Type::kScroll, "scroll", 2, 0},
+  {InputEvent::Type::kKey, "key", 0, 4},
+  {InputEvent::Type::kRefresh, "refresh", 0, 0},
+  {InputEvent::Type::kMaxIter, "max_iter", 0, 1},
+};
+
+
+const EventFormat& FormatOf(InputEvent::Type type) {
+  for (const EventFormat& format : kFormats) {
+    if (format.type == type) {
+      return format;
+    }
+  }
+  return kFormats[0];
+}
+
+}  // namespace
+
+
+void WriteSessionHeader(std::ostream& out) {
+  out << "# fractal session\n";
+}
+
+
+void WriteInputEvent(std::ostream& out, const InputEvent& event) {
+  const EventFormat& format = FormatOf(event.type);
+  char line[128];
+  int n = std::snprintf(line, sizeof(line), "%.6f %s", event.time,
+                        format.name);
+  if (format.doubles > 0) {
+    n += std::snprintf(line + n, sizeof(line) - n, " %.17g %.17g", event.x,
+                       event.y);
+  }
+  for (int i = 0; i < format.ints; ++i) {
+    n += std::snprintf(line + n, sizeof(line) - n, " %d", event.args[i]);
+  }
+  out << line << '\n';
+}
+
+
+bool ReadSession(std::istream& in, std::vector<InputEvent>* events,
+                 std::string* error) {
+  std::string line;
+  for (int line_number = 1; std::getline(in, line); ++line_number) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    InputEvent event;
+    std::string name;
+    fields >> event.time >> name;
+
+    const EventFormat* format = nullptr;
+    for (const EventFormat& f : kFormats) {
+      if (name == f.name) {
+        format = &f;
+      }
+    }
+    if (!fields || format == nullptr) {
+      *error = "line " + std::to_string(line_number) + ": unknown event " +
+               name;
+      return false;
+    }
+    event.type = format->type;
+    if (format->doubles > 0) {
+      fields >> event.x >> event.y;
+    }
+    for (int i = 0; i < format->ints; ++i) {
+      fields >> event.args[i];
+    }
+    if (!fields) {
+      *error = "line " + std::to_string(line_number) + ": bad " + name +
+               " event";
+      return false;
+    }
+    events->push_back(event);
+  }
+  return true;
+}
@@ -71,6 +71,8 @@ Shader::Shader(const char* vertex_path, const char* fragment_path) {
 
   glDeleteShader(vertex);
   glDeleteShader(fragment);
+
+  CacheUniformLocations();
 }
 
 
@@ -79,16 +81,106 @@ void Shader::Use() const {
 }
 
 
-void Shader::SetUniform(std::string name, double v) const {
-  glUniform1d(glGetUniformLocation(id, name.c_str()), v); 
+int Shader::UniformLocation(const std::string& name) const {
+  const auto it = uniform_locations_.find(name);
+  return it == uniform_locations_.end() ? -1 : it->second;
+}
+
+
+void Shader::SetUniform(const std::string& name, double v) const {
+  SetUniform(Uniform<double>{UniformLocation(name)}, v);
+}
+
+
+void Shader::SetUniform(const std::string& name, glm::dvec2 v) const {
+  SetUniform(Uniform<glm::dvec2>{UniformLocation(name)}, v);
+}
+
+
+void Shader::SetUniform(const std::string& name, float v) const {
+  SetUniform(Uniform<float>{UniformLocation(name)}, v);
+}
+
+
+void Shader::SetUniform(const std::string& name, glm::vec2 v) const {
+  SetUniform(Uniform<glm::vec2>{UniformLocation(name)}, v);
+}
+
+
+void Shader::SetUniform(const std::string& name, int v) const {
+  SetUniform(Uniform<int>{UniformLocation(name)}, v);
+}
+
+
+void Shader::SetUniform(Uniform<double> u, double v) const {
+  glUniform1d(u.location, v);
 }
 
 
-void Shader::SetUniform(std::string name, glm::dvec2 v) const {
-  glUniform2d(glGetUniformLocation(id, name.c_str()), v.x, v.y); 
+void Shader::SetUniform(Uniform<glm::dvec2> u, glm::dvec2 v) const {
+  glUniform2d(u.location, v.x, v.y);
 }
 
 
-void Shader::SetUniform(std::string name, int v) const {
-  glUniform1i(glGetUniformLocation(id, name.c_str()), v); 
+void Shader::SetUniform(Uniform<float> u, float v) const {
+  glUniform1f(u.location, v);
+}
+
+
+void Shader::SetUniform(Uniform<glm::vec2> u, glm::vec2 v) const {
+  glUniform2f(u.location, v.x, v.y);
+}
+
+
+void Shader::SetUniform(Uniform<int> u, int v) const {
+  glUniform1i(u.location, v);
+}
+
+
+void Shader::BindUniformBlock(const std::string& name,
+                              unsigned int binding) const {
+  const unsigned int index = glGetUniformBlockIndex(id, name.c_str());
+  if (index != GL_INVALID_INDEX) {
+    glUniformBlockBinding(id, index, binding);
+  }
+}
+
+
+// Queries every active uniform once after linking so that setting a uniform
+// never has to go through glGetUniformLocation.
+void Shader::CacheUniformLocations() {
+  int count = 0;
+  int max_length = 0;
+  glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+  std::string name(max_length, '\0');
+  for (int i = 0; i < count; ++i) {
+    int length, size;
+    GLenum type;
+    glGetActiveUniform(id, i, max_length, &length, &size, &type, name.data());
+    const std::string uniform_name = name.substr(0, length);
+    const int location = glGetUniformLocation(id, uniform_name.c_str());
+    uniform_locations_[uniform_name] = location;
+
+    // Arrays are reported as "name[0]"; make them reachable as "name" too.
+    const auto bracket = uniform_name.find('[');
+    if (bracket != std::string::npos) {
+      uniform_locations_[uniform_name.substr(0, bracket)] = location;
+    }
+  }
+}
+
+
+bool HasGlExtension(const std::string& name) {
+  int count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (int i = 0; i < count; ++i) {
+    const auto* extension =
+        reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+    if (extension != nullptr && name == extension) {
+      return true;
+    }
+  }
+  return false;
 }
@@ -0,0 +1,189 @@
+#include "tile_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+
+double SecondsSince(Clock::time_point t) {
+  return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+}  // namespace
+
+
+TileScheduler::TileScheduler(int num_threads) {
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (int i = 1; i < num_threads; ++i) {
+    workers_[i]->thread = std::thread(&TileScheduler::ThreadLoop, this, i);
+  }
+}
+
+
+TileScheduler::~TileScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (int i = 1; i < num_threads(); ++i) {
+    workers_[i]->thread.join();
+  }
+}
+
+
+void TileScheduler::Run(int width, int height,
+                        const std::function<void(const Tile&)>& task) {
+  const int tiles_x = (width + tile_size_ - 1)/tile_size_;
+  const int tiles_y = (height + tile_size_ - 1)/tile_size_;
+  const int num_tiles = tiles_x*tiles_y;
+  if (num_tiles <= 0) {
+    return;
+  }
+
+  // Hand out contiguous blocks of tiles so that a worker's own tiles are
+  // neighbours; stealing takes care of the cost imbalance between blocks.
+  const int n = num_threads();
+  for (int i = 0; i < num_tiles; ++i) {
+    const int x0 = (i % tiles_x)*tile_size_;
+    const int y0 = (i / tiles_x)*tile_size_;
+    const Tile tile{x0, y0, std::min(x0 + tile_size_, width),
+                    std::min(y0 + tile_size_, height)};
+    auto& worker = *workers_[static_cast<long>(i)*n/num_tiles];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tiles.push_back(tile);
+  }
+
+  const auto start = Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    finished_ = 0;
+    ++generation_;
+  }
+  start_cv_.notify_all();
+
+  Work(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [&] { return finished_ == n - 1; });
+  task_ = nullptr;
+
+  // A worker that ran out of tiles waits for the run to end, so its idle
+  // time is whatever of the run it did not spend on tiles.
+  const double seconds = SecondsSince(start);
+  for (const auto& worker : workers_) {
+    worker->stats.idle_seconds += seconds - worker->run_busy_seconds;
+  }
+}
+
+
+void TileScheduler::ThreadLoop(int index) {
+  unsigned long seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [&] {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+
+    Work(index);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++finished_;
+    }
+    done_cv_.notify_one();
+  }
+}
+
+
+// Runs tiles until there are none left to pop or steal. Tiles are only
+// queued before a run starts, so once that happens everything left is
+// already being computed by another worker and this one is done.
+void TileScheduler::Work(int index) {
+  auto& worker = *workers_[index];
+  double busy = 0.0;
+
+  Tile tile;
+  while (Pop(index, tile) || Steal(index, tile)) {
+    const auto t = Clock::now();
+    (*task_)(tile);
+    busy += SecondsSince(t);
+    ++worker.stats.tiles_run;
+  }
+
+  worker.stats.busy_seconds += busy;
+  worker.run_busy_seconds = busy;
+}
+
+
+bool TileScheduler::Pop(int index, Tile& tile) {
+  auto& worker = *workers_[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.tiles.empty()) {
+    return false;
+  }
+  tile = worker.tiles.front();
+  worker.tiles.pop_front();
+  return true;
+}
+
+
+bool TileScheduler::Steal(int index, Tile& tile) {
+  const int n = num_threads();
+  for (int i = 1; i < n; ++i) {
+    auto& victim = *workers_[(index + i) % n];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tiles.empty()) {
+      tile = victim.tiles.back();
+      victim.tiles.pop_back();
+      ++workers_[index]->stats.tiles_stolen;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+std::vector<WorkerStats> TileScheduler::stats() const {
+  std::vector<WorkerStats> result;
+  for (const auto& worker : workers_) {
+    result.push_back(worker->stats);
+  }
+  return result;
+}
+
+
+void TileScheduler::ResetStats() {
+  for (auto& worker : workers_) {
+    worker->stats = {};
+  }
+}
+
+
+void TileScheduler::PrintStats() const {
+  std::printf("%6s %10s %10s %10s %10s\n",
+              "worker", "tiles", "stolen", "busy [s]", "idle [s]");
+  for (int i = 0; i < num_threads(); ++i) {
+    const auto& s = workers_[i]->stats;
+    std::printf("%6d %10ld %10ld %10.3f %10.3f\n",
+                i, s.tiles_run, s.tiles_stolen, s.busy_seconds,
+                s.idle_seconds);
+  }
+}